@@ -0,0 +1,73 @@
+#include <AngleCorrection.h>
+#include <cmath>
+#include <new>
+
+namespace sensorYDLidarX4 {
+
+int16_t *AngleCorrection::table = nullptr;
+int32_t AngleCorrection::interpolatedTable[AngleCorrection::interpolatedEntries];
+bool AngleCorrection::isInterpolatedTableBuilt = false;
+
+AngleCorrection::AngleCorrection()
+  : mode(ANGLE_CORRECTION_EXACT)
+{
+  buildInterpolatedTable();
+}
+
+// returns false (and keeps the old mode) if the full table could not be allocated
+bool AngleCorrection::setMode(AngleCorrectionMode mode){
+  if(mode == ANGLE_CORRECTION_TABLE && !buildTable()){
+    return false;
+  }
+  this->mode = mode;
+  return true;
+}
+
+AngleCorrectionMode AngleCorrection::getMode(){
+  return mode;
+}
+
+bool AngleCorrection::buildTable(){
+  if(table != nullptr){
+    return true;
+  }
+  int16_t *newTable = new (std::nothrow) int16_t[UINT16_MAX+1];
+  if(newTable == nullptr){
+    return false;
+  }
+  for(uint32_t distance=0; distance<=UINT16_MAX; distance++){
+    newTable[distance] = (int16_t)lround(exactInDegree(distance) * 256);
+  }
+  table = newTable;
+  return true;
+}
+
+void AngleCorrection::buildInterpolatedTable(){
+  if(isInterpolatedTableBuilt){
+    return;
+  }
+  for(size_t distance=0; distance<directEntries; distance++){
+    interpolatedTable[distance] = lround(exactInDegree(distance) * 65536.0);
+  }
+  for(size_t index=directEntries; index<interpolatedEntries; index++){
+    size_t octave = firstOctave + (index-directEntries) / segmentsPerOctave;
+    size_t segment = (index-directEntries) % segmentsPerOctave;
+    uint32_t distance = (1 << octave) + (segment << (octave - segmentsPerOctaveLog2));
+    // the last entry (65536) is one step behind the largest raw distance
+    double distanceInMillimeter = distance/4.0;
+    double correction = atan(21.8*((155.3-distanceInMillimeter)/(155.3*distanceInMillimeter))) * (180/3.14159265359);
+    interpolatedTable[index] = lround(correction * 65536.0);
+  }
+  isInterpolatedTableBuilt = true;
+}
+
+float AngleCorrection::exactInDegree(uint16_t distance){
+  float distanceInMillimeter = distance/4.0;
+  if(distanceInMillimeter == 0){
+    return 0;
+  }
+  static float inDegree = 180/3.14159265359;
+  return atan(21.8*((155.3-distanceInMillimeter)/(155.3*distanceInMillimeter)))*inDegree;
+}
+
+} // end namespace
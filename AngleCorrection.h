@@ -0,0 +1,99 @@
+#ifndef __ANGLE_CORRECTION__
+#define __ANGLE_CORRECTION__
+
+#include <cstdint>
+#include <cstddef>
+#include <AngleCorrectionMode.h>
+
+namespace sensorYDLidarX4 {
+
+/*
+distance dependent angle correction of the YDLidarX4
+
+  correction = atan(21.8 * (155.3 - distance) / (155.3 * distance))
+
+the raw distance is a uint16_t in 0.25mm steps, so the correction can be tabulated.
+the tables are built once on the first setMode() that needs them and are shared
+by all instances.
+
+ANGLE_CORRECTION_TABLE        one int16_t per raw distance in 1/256 degree
+ANGLE_CORRECTION_INTERPOLATED raw distances < 64 exact, then 32 linear segments per
+                              power of two (fixed point 1/65536 degree)
+
+inFixedPoint() never uses floats: it reads the full table in ANGLE_CORRECTION_TABLE
+mode and the interpolated table otherwise, which is therefore always built.
+*/
+
+class AngleCorrection{
+  private:
+    const static size_t directEntries = 64;
+    const static size_t segmentsPerOctaveLog2 = 5;
+    const static size_t segmentsPerOctave = 1 << segmentsPerOctaveLog2;
+    const static size_t firstOctave = 6; // log2(directEntries)
+    const static size_t interpolatedEntries = directEntries + (16-firstOctave)*segmentsPerOctave + 1;
+
+    static int16_t *table;
+    static int32_t interpolatedTable[interpolatedEntries];
+    static bool isInterpolatedTableBuilt;
+
+    AngleCorrectionMode mode;
+
+    static bool buildTable();
+    static void buildInterpolatedTable();
+
+  public:
+    AngleCorrection();
+    bool setMode(AngleCorrectionMode mode);
+    AngleCorrectionMode getMode();
+
+    float inDegree(uint16_t distance);
+    int32_t inFixedPoint(uint16_t distance);
+
+    static float exactInDegree(uint16_t distance);
+    static float tableInDegree(uint16_t distance);
+    static float interpolatedInDegree(uint16_t distance);
+    static int32_t interpolatedInFixedPoint(uint16_t distance);
+};
+
+inline float AngleCorrection::inDegree(uint16_t distance){
+  switch (mode){
+    case ANGLE_CORRECTION_TABLE:        return tableInDegree(distance);
+    case ANGLE_CORRECTION_INTERPOLATED: return interpolatedInDegree(distance);
+    default:                            return exactInDegree(distance);
+  }
+}
+
+// correction in 1/65536 degree
+inline int32_t AngleCorrection::inFixedPoint(uint16_t distance){
+  if(mode == ANGLE_CORRECTION_TABLE){
+    return (int32_t)table[distance] << 8;
+  }
+  return interpolatedInFixedPoint(distance);
+}
+
+inline float AngleCorrection::tableInDegree(uint16_t distance){
+  return table[distance] * (1.0f/256);
+}
+
+inline float AngleCorrection::interpolatedInDegree(uint16_t distance){
+  return interpolatedInFixedPoint(distance) * (1.0f/65536);
+}
+
+// correction in 1/65536 degree
+inline int32_t AngleCorrection::interpolatedInFixedPoint(uint16_t distance){
+  if(distance < directEntries){
+    return interpolatedTable[distance];
+  }
+  size_t octave = 31 - __builtin_clz(distance);
+  size_t shift = octave - segmentsPerOctaveLog2;
+  size_t offset = distance - (1 << octave);
+  size_t index = directEntries + (octave-firstOctave)*segmentsPerOctave + (offset >> shift);
+  int32_t fraction = offset & ((1 << shift) - 1);
+  int32_t lower = interpolatedTable[index];
+  int32_t upper = interpolatedTable[index+1];
+  return lower + (int32_t)(((int64_t)(upper - lower) * fraction) >> shift);
+}
+
+} // end namespace
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef __ANGLE_CORRECTION_MODE__
+#define __ANGLE_CORRECTION_MODE__
+
+namespace sensorYDLidarX4{
+
+enum AngleCorrectionMode{
+  ANGLE_CORRECTION_EXACT,         // atan per sample
+  ANGLE_CORRECTION_TABLE,         // one entry per raw distance, 128kB heap, error <= 0.002 degree
+  ANGLE_CORRECTION_INTERPOLATED   // piecewise linear table, 1.5kB, error <= 0.006 degree
+};
+
+} // end namespace
+
+#endif
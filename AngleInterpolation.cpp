@@ -0,0 +1,84 @@
+#include <AngleInterpolation.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace sensorYDLidarX4 {
+
+void interpolateAnglesInDegree(float startAngleInDegree, float stopAngleInDegree, size_t sampleQuantity, float *anglesInDegree){
+  float diffInDegree = stopAngleInDegree - startAngleInDegree;
+  if(diffInDegree < 0){
+    diffInDegree += 360;
+  }
+  // sampleQuantity==1 would be a DIV0
+  float stepInDegree = sampleQuantity > 1 ? diffInDegree / (sampleQuantity - 1) : 0;
+  size_t sampleNum = 0;
+
+  // start + sampleNum*step with an exact float sample number, so no error accumulates
+#if defined(__SSE2__)
+  __m128 start = _mm_set1_ps(startAngleInDegree);
+  __m128 step = _mm_set1_ps(stepInDegree);
+  __m128 index = _mm_setr_ps(0, 1, 2, 3);
+  __m128 four = _mm_set1_ps(4);
+  for(; sampleNum+4 <= sampleQuantity; sampleNum+=4){
+    _mm_storeu_ps(anglesInDegree+sampleNum, _mm_add_ps(start, _mm_mul_ps(index, step)));
+    index = _mm_add_ps(index, four);
+  }
+#elif defined(__ARM_NEON)
+  float32x4_t start = vdupq_n_f32(startAngleInDegree);
+  const float firstIndices[4] = {0, 1, 2, 3};
+  float32x4_t index = vld1q_f32(firstIndices);
+  float32x4_t four = vdupq_n_f32(4);
+  for(; sampleNum+4 <= sampleQuantity; sampleNum+=4){
+    vst1q_f32(anglesInDegree+sampleNum, vmlaq_n_f32(start, index, stepInDegree));
+    index = vaddq_f32(index, four);
+  }
+#else
+  for(; sampleNum+4 <= sampleQuantity; sampleNum+=4){
+    float index = sampleNum;
+    anglesInDegree[sampleNum]   = startAngleInDegree + index * stepInDegree;
+    anglesInDegree[sampleNum+1] = startAngleInDegree + (index+1) * stepInDegree;
+    anglesInDegree[sampleNum+2] = startAngleInDegree + (index+2) * stepInDegree;
+    anglesInDegree[sampleNum+3] = startAngleInDegree + (index+3) * stepInDegree;
+  }
+#endif
+
+  for(; sampleNum < sampleQuantity; sampleNum++){
+    anglesInDegree[sampleNum] = startAngleInDegree + (float)sampleNum * stepInDegree;
+  }
+}
+
+void distancesInMillimeter(const uint16_t *distances, size_t sampleQuantity, float *rangesInMillimeter){
+  size_t sampleNum = 0;
+
+#if defined(__SSE2__)
+  __m128i zero = _mm_setzero_si128();
+  __m128 quarter = _mm_set1_ps(0.25f);
+  for(; sampleNum+4 <= sampleQuantity; sampleNum+=4){
+    __m128i distances16 = _mm_loadl_epi64((const __m128i*)(distances+sampleNum));
+    __m128i distances32 = _mm_unpacklo_epi16(distances16, zero);
+    _mm_storeu_ps(rangesInMillimeter+sampleNum, _mm_mul_ps(_mm_cvtepi32_ps(distances32), quarter));
+  }
+#elif defined(__ARM_NEON)
+  for(; sampleNum+4 <= sampleQuantity; sampleNum+=4){
+    uint32x4_t distances32 = vmovl_u16(vld1_u16(distances+sampleNum));
+    vst1q_f32(rangesInMillimeter+sampleNum, vmulq_n_f32(vcvtq_f32_u32(distances32), 0.25f));
+  }
+#else
+  for(; sampleNum+4 <= sampleQuantity; sampleNum+=4){
+    rangesInMillimeter[sampleNum]   = distances[sampleNum]   * 0.25f;
+    rangesInMillimeter[sampleNum+1] = distances[sampleNum+1] * 0.25f;
+    rangesInMillimeter[sampleNum+2] = distances[sampleNum+2] * 0.25f;
+    rangesInMillimeter[sampleNum+3] = distances[sampleNum+3] * 0.25f;
+  }
+#endif
+
+  for(; sampleNum < sampleQuantity; sampleNum++){
+    rangesInMillimeter[sampleNum] = distances[sampleNum] * 0.25f;
+  }
+}
+
+} // end namespace
@@ -0,0 +1,31 @@
+#ifndef __ANGLE_INTERPOLATION__
+#define __ANGLE_INTERPOLATION__
+
+#include <cstdint>
+#include <cstddef>
+
+namespace sensorYDLidarX4 {
+
+// fills anglesInDegree with sampleQuantity angles evenly spaced from start to stop.
+// a stop angle below the start angle is a paket across 0 degree: the angles run on
+// over 360 and have to be wrapped by the caller (see wrapAngleInDegree).
+// the step is computed once, uses SSE/NEON when available and a 4x unrolled loop otherwise (ESP32)
+void interpolateAnglesInDegree(float startAngleInDegree, float stopAngleInDegree, size_t sampleQuantity, float *anglesInDegree);
+
+// rangesInMillimeter[i] = distances[i] / 4, same vector paths as above
+void distancesInMillimeter(const uint16_t *distances, size_t sampleQuantity, float *rangesInMillimeter);
+
+// maps an angle of [-360, 720) to [0, 360)
+inline float wrapAngleInDegree(float angleInDegree){
+  if(angleInDegree < 0){
+    return angleInDegree + 360;
+  }
+  if(angleInDegree >= 360){
+    return angleInDegree - 360;
+  }
+  return angleInDegree;
+}
+
+} // end namespace
+
+#endif
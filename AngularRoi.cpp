@@ -0,0 +1,117 @@
+#include <AngularRoi.h>
+#include <cmath>
+#include <initializer_list>
+
+namespace sensorYDLidarX4 {
+
+AngularRoi::AngularRoi()
+  : sectorCount(0)
+{
+  resetCounters();
+}
+
+bool AngularRoi::addSector(float fromInDegree, float toInDegree){
+  if(sectorCount >= maxSectors){
+    return false;
+  }
+  int32_t from = lround(fromInDegree * 64) % fullCircleInQ6Degree;
+  int32_t to = lround(toInDegree * 64) % fullCircleInQ6Degree;
+  from = from < 0 ? from + fullCircleInQ6Degree : from;
+  to = to < 0 ? to + fullCircleInQ6Degree : to;
+  int32_t width = to - from;
+  fromInQ6Degree[sectorCount] = from;
+  widthInQ6Degree[sectorCount] = width > 0 ? width : width + fullCircleInQ6Degree;
+  sectorCount++;
+  return true;
+}
+
+void AngularRoi::clear(){
+  sectorCount = 0;
+}
+
+bool AngularRoi::select(uint16_t startAngleInQ6Degree, uint16_t lastAngleInQ6Degree, uint8_t sampleQuantity, uint8_t &firstSample, uint8_t &selectedQuantity){
+  firstSample = 0;
+  selectedQuantity = sampleQuantity;
+  if(sectorCount == 0 || sampleQuantity == 0){
+    return true;
+  }
+
+  int32_t diffInQ6Degree = (int32_t)lastAngleInQ6Degree - startAngleInQ6Degree;
+  if(diffInQ6Degree < 0){
+    diffInQ6Degree += fullCircleInQ6Degree;
+  }
+  int32_t lastSample = sampleQuantity - 1;
+  int32_t first = sampleQuantity;
+  int32_t last = -1;
+  for(size_t sector=0; sector<sectorCount; sector++){
+    int32_t sectorFirst, sectorLast;
+    if(selectInSector(sector, startAngleInQ6Degree, diffInQ6Degree, lastSample, sectorFirst, sectorLast)){
+      first = sectorFirst < first ? sectorFirst : first;
+      last = sectorLast > last ? sectorLast : last;
+    }
+  }
+
+  if(last < first){
+    skippedPaketCount++;
+    skippedSampleCount += sampleQuantity;
+    selectedQuantity = 0;
+    return false;
+  }
+  firstSample = first;
+  selectedQuantity = last - first + 1;
+  skippedSampleCount += sampleQuantity - selectedQuantity;
+  selectedSampleCount += selectedQuantity;
+  return true;
+}
+
+// intersects the paket [0, diff] with the sector, both relative to the paket start
+bool AngularRoi::selectInSector(size_t sector, int32_t startInQ6Degree, int32_t diffInQ6Degree, int32_t lastSample, int32_t &first, int32_t &last){
+  int32_t sectorStart = fromInQ6Degree[sector] - startInQ6Degree;
+  if(sectorStart < 0){
+    sectorStart += fullCircleInQ6Degree;
+  }
+  first = lastSample + 1;
+  last = -1;
+  // the sector may also reach into the paket from the revolution before
+  for(int32_t shiftedStart : {sectorStart - fullCircleInQ6Degree, sectorStart}){
+    int32_t low = shiftedStart > 0 ? shiftedStart : 0;
+    int32_t shiftedEnd = shiftedStart + widthInQ6Degree[sector];
+    int32_t high = shiftedEnd < diffInQ6Degree ? shiftedEnd : diffInQ6Degree;
+    if(low > high){
+      continue;
+    }
+    if(diffInQ6Degree == 0){
+      first = 0;
+      last = lastSample;
+      return true;
+    }
+    // sample i is at i*diff/lastSample
+    int32_t lowSample = (low * lastSample + diffInQ6Degree - 1) / diffInQ6Degree;
+    int32_t highSample = high * lastSample / diffInQ6Degree;
+    if(lowSample <= highSample){
+      first = lowSample < first ? lowSample : first;
+      last = highSample > last ? highSample : last;
+    }
+  }
+  return first <= last;
+}
+
+unsigned long AngularRoi::getSkippedPaketCount(){
+  return skippedPaketCount;
+}
+
+unsigned long AngularRoi::getSkippedSampleCount(){
+  return skippedSampleCount;
+}
+
+unsigned long AngularRoi::getSelectedSampleCount(){
+  return selectedSampleCount;
+}
+
+void AngularRoi::resetCounters(){
+  skippedPaketCount = 0;
+  skippedSampleCount = 0;
+  selectedSampleCount = 0;
+}
+
+} // end namespace
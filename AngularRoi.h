@@ -0,0 +1,61 @@
+#ifndef __ANGULAR_ROI__
+#define __ANGULAR_ROI__
+
+#include <cstdint>
+#include <cstddef>
+
+namespace sensorYDLidarX4 {
+
+/*
+angular regions of interest on the raw paket angles
+
+a sector runs counter clockwise from its first to its second angle and may wrap
+across 0 degree (addSector(270, 90) is the forward half). select() works on the
+raw start and last angle of a paket before anything is decoded: pakets outside
+all sectors are skipped, the samples at the paket edges outside the sectors are
+trimmed. gaps between two sectors inside one paket are kept. the selection uses
+the uncorrected angles, so samples close to the edges may end up a few degree
+outside after the distance dependent correction.
+
+without any sector everything is selected.
+
+  static AngularRoi roi;
+  roi.addSector(270, 90);
+  YDLidarX4::builder().setAngularRoi(roi)...
+*/
+
+class AngularRoi{
+  public:
+    const static size_t maxSectors = 8;
+
+  private:
+    const static int32_t fullCircleInQ6Degree = 360*64;
+
+    int32_t fromInQ6Degree[maxSectors];
+    int32_t widthInQ6Degree[maxSectors];
+    size_t sectorCount;
+
+    unsigned long skippedPaketCount;
+    unsigned long skippedSampleCount;
+    unsigned long selectedSampleCount;
+
+    bool selectInSector(size_t sector, int32_t startInQ6Degree, int32_t diffInQ6Degree, int32_t lastSample, int32_t &first, int32_t &last);
+
+  public:
+    AngularRoi();
+    // returns false if all sectors are used. equal angles are the full circle
+    bool addSector(float fromInDegree, float toInDegree);
+    void clear();
+
+    // returns false if the paket can be skipped, otherwise the first selected sample and the selected count
+    bool select(uint16_t startAngleInQ6Degree, uint16_t lastAngleInQ6Degree, uint8_t sampleQuantity, uint8_t &firstSample, uint8_t &selectedQuantity);
+
+    unsigned long getSkippedPaketCount();
+    unsigned long getSkippedSampleCount();
+    unsigned long getSelectedSampleCount();
+    void resetCounters();
+};
+
+} // end namespace
+
+#endif
@@ -0,0 +1,76 @@
+#include <CartesianConverter.h>
+#include <cmath>
+
+namespace sensorYDLidarX4 {
+
+int16_t CartesianConverter::sineTable[CartesianConverter::quarterCircleInQ6Degree+1];
+bool CartesianConverter::isSineTableBuilt = false;
+
+CartesianConverter::CartesianConverter()
+  : offsetXInMillimeter(0),
+  offsetYInMillimeter(0),
+  rotationInQ6Degree(0)
+{
+  buildSineTable();
+}
+
+void CartesianConverter::buildSineTable(){
+  if(isSineTableBuilt){
+    return;
+  }
+  for(size_t angle=0; angle<=quarterCircleInQ6Degree; angle++){
+    sineTable[angle] = (int16_t)lround(sin(angle * (3.14159265359/180/64)) * sineOne);
+  }
+  isSineTableBuilt = true;
+}
+
+// rotation in degree, positive is counter clockwise
+void CartesianConverter::setMountingOffset(int16_t offsetXInMillimeter, int16_t offsetYInMillimeter, float rotationInDegree){
+  this->offsetXInMillimeter = offsetXInMillimeter;
+  this->offsetYInMillimeter = offsetYInMillimeter;
+  int32_t rotation = lround(rotationInDegree * 64) % fullCircleInQ6Degree;
+  this->rotationInQ6Degree = rotation < 0 ? rotation + fullCircleInQ6Degree : rotation;
+}
+
+inline int16_t CartesianConverter::clamp(int32_t value){
+  return value > INT16_MAX ? INT16_MAX : (value < -INT16_MAX ? -INT16_MAX : value);
+}
+
+size_t CartesianConverter::toPoints(const uint16_t anglesInQ6Degree[], const uint16_t rangesInQuarterMillimeter[], size_t lenght, LidarPoint points[]){
+  size_t pointCount = 0;
+  for(size_t sampleNum=0; sampleNum<lenght; sampleNum++){
+    int32_t range = rangesInQuarterMillimeter[sampleNum];
+    if(range == 0){
+      continue;
+    }
+    uint16_t angle = anglesInQ6Degree[sampleNum] + rotationInQ6Degree;
+    angle = angle < fullCircleInQ6Degree ? angle : angle - fullCircleInQ6Degree;
+    // 0.25mm * 1/16384 -> mm with rounding
+    int32_t x = (range * cosine(angle) + (1 << 15)) >> 16;
+    int32_t y = (range * sine(angle) + (1 << 15)) >> 16;
+    points[pointCount].xInMillimeter = clamp(x + offsetXInMillimeter);
+    points[pointCount].yInMillimeter = clamp(y + offsetYInMillimeter);
+    pointCount++;
+  }
+  return pointCount;
+}
+
+size_t CartesianConverter::toPoints(const uint16_t anglesInQ6Degree[], const uint16_t rangesInQuarterMillimeter[], size_t lenght, LidarFloatPoint points[]){
+  const float scale = 1.0f / (4 * sineOne);
+  size_t pointCount = 0;
+  for(size_t sampleNum=0; sampleNum<lenght; sampleNum++){
+    uint16_t range = rangesInQuarterMillimeter[sampleNum];
+    if(range == 0){
+      continue;
+    }
+    uint16_t angle = anglesInQ6Degree[sampleNum] + rotationInQ6Degree;
+    angle = angle < fullCircleInQ6Degree ? angle : angle - fullCircleInQ6Degree;
+    float rangeScaled = range * scale;
+    points[pointCount].xInMillimeter = rangeScaled * cosine(angle) + offsetXInMillimeter;
+    points[pointCount].yInMillimeter = rangeScaled * sine(angle) + offsetYInMillimeter;
+    pointCount++;
+  }
+  return pointCount;
+}
+
+} // end namespace
@@ -0,0 +1,80 @@
+#ifndef __CARTESIAN_CONVERTER__
+#define __CARTESIAN_CONVERTER__
+
+#include <cstdint>
+#include <cstddef>
+
+namespace sensorYDLidarX4 {
+
+struct LidarPoint{
+  int16_t xInMillimeter;
+  int16_t yInMillimeter;
+};
+
+struct LidarFloatPoint{
+  float xInMillimeter;
+  float yInMillimeter;
+};
+
+/*
+converts the fixed point samples to x/y in the frame of the robot
+
+  x = range * cos(angle + rotation) + offsetX
+  y = range * sin(angle + rotation) + offsetY
+
+sin/cos come from a quarter wave table with one int16_t (1/16384) per 1/64 degree,
+which is built once and shared by all instances (11.5kB). samples without a range
+(0) are skipped, so the point count can be lower than the sample count.
+int16_t coordinates are clamped to +-32767mm.
+*/
+
+class CartesianConverter{
+  private:
+    const static uint16_t fullCircleInQ6Degree = 360*64;
+    const static uint16_t quarterCircleInQ6Degree = 90*64;
+    const static int32_t sineOne = 1 << 14;
+
+    static int16_t sineTable[quarterCircleInQ6Degree+1];
+    static bool isSineTableBuilt;
+
+    int16_t offsetXInMillimeter;
+    int16_t offsetYInMillimeter;
+    uint16_t rotationInQ6Degree;
+
+    static void buildSineTable();
+    static int16_t clamp(int32_t value);
+
+  public:
+    CartesianConverter();
+    void setMountingOffset(int16_t offsetXInMillimeter, int16_t offsetYInMillimeter, float rotationInDegree);
+
+    // both return the number of points written, points need lenght elements
+    size_t toPoints(const uint16_t anglesInQ6Degree[], const uint16_t rangesInQuarterMillimeter[], size_t lenght, LidarPoint points[]);
+    size_t toPoints(const uint16_t anglesInQ6Degree[], const uint16_t rangesInQuarterMillimeter[], size_t lenght, LidarFloatPoint points[]);
+
+    static int16_t sine(uint16_t angleInQ6Degree);
+    static int16_t cosine(uint16_t angleInQ6Degree);
+};
+
+// angle in [0, 360*64), result in 1/16384
+inline int16_t CartesianConverter::sine(uint16_t angleInQ6Degree){
+  if(angleInQ6Degree < quarterCircleInQ6Degree){
+    return sineTable[angleInQ6Degree];
+  }
+  if(angleInQ6Degree < 2*quarterCircleInQ6Degree){
+    return sineTable[2*quarterCircleInQ6Degree - angleInQ6Degree];
+  }
+  if(angleInQ6Degree < 3*quarterCircleInQ6Degree){
+    return -sineTable[angleInQ6Degree - 2*quarterCircleInQ6Degree];
+  }
+  return -sineTable[fullCircleInQ6Degree - angleInQ6Degree];
+}
+
+inline int16_t CartesianConverter::cosine(uint16_t angleInQ6Degree){
+  uint16_t shiftedAngle = angleInQ6Degree + quarterCircleInQ6Degree;
+  return sine(shiftedAngle < fullCircleInQ6Degree ? shiftedAngle : shiftedAngle - fullCircleInQ6Degree);
+}
+
+} // end namespace
+
+#endif
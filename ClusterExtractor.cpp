@@ -0,0 +1,137 @@
+#include <ClusterExtractor.h>
+#include <cmath>
+
+namespace sensorYDLidarX4 {
+
+const static float toRad = 3.14159265359f / 180;
+
+ClusterExtractor::ClusterExtractor()
+  : clusterCount(0),
+  droppedClusterCount(0),
+  handler(nullptr),
+  hasRevolutionStart(false),
+  lambdaInRad(10 * toRad),
+  sigmaInMillimeter(10),
+  minPoints(3),
+  hasPreviousPoint(false)
+{
+}
+
+void ClusterExtractor::setHandler(OnLidarClustersHandler &handler){
+  this->handler = &handler;
+}
+
+// lambda is the flattest angle under which a surface is still seen as one object
+void ClusterExtractor::setBreakpoint(float lambdaInDegree, float sigmaInMillimeter){
+  this->lambdaInRad = lambdaInDegree * toRad;
+  this->sigmaInMillimeter = sigmaInMillimeter;
+}
+
+void ClusterExtractor::setMinPoints(uint16_t minPoints){
+  this->minPoints = minPoints > 0 ? minPoints : 1;
+}
+
+void ClusterExtractor::reset(){
+  clusterCount = 0;
+  hasPreviousPoint = false;
+  hasRevolutionStart = false;
+}
+
+void ClusterExtractor::add(const float anglesInDegree[], const float rangesInMillimeter[], size_t lenght){
+  for(size_t sampleNum=0; sampleNum<lenght; sampleNum++){
+    float range = rangesInMillimeter[sampleNum];
+    if(range <= 0){
+      continue;
+    }
+    float angle = anglesInDegree[sampleNum];
+    float x = range * cosf(angle * toRad);
+    float y = range * sinf(angle * toRad);
+    if(!hasPreviousPoint || isBreakpoint(angle, x, y)){
+      if(hasPreviousPoint){
+        finishCluster();
+      }
+      startCluster(angle, range, x, y);
+    }else{
+      sumXInMillimeter += x;
+      sumYInMillimeter += y;
+      running.pointCount++;
+      running.endAngleInDegree = angle;
+      if(range < running.nearestRangeInMillimeter){
+        running.nearestRangeInMillimeter = range;
+        running.nearestAngleInDegree = angle;
+      }
+    }
+    previousXInMillimeter = x;
+    previousYInMillimeter = y;
+    previousRangeInMillimeter = range;
+    previousAngleInDegree = angle;
+    hasPreviousPoint = true;
+  }
+}
+
+bool ClusterExtractor::isBreakpoint(float angleInDegree, float xInMillimeter, float yInMillimeter){
+  // the corrected angles are not strictly increasing, only the size of the step counts
+  float angleStep = fabsf(angleInDegree - previousAngleInDegree);
+  if(angleStep > 180){
+    angleStep = 360 - angleStep;
+  }
+  angleStep *= toRad;
+  if(angleStep >= lambdaInRad){
+    return true;
+  }
+  float maxDistance = previousRangeInMillimeter * sinf(angleStep) / sinf(lambdaInRad - angleStep) + 3 * sigmaInMillimeter;
+  float dx = xInMillimeter - previousXInMillimeter;
+  float dy = yInMillimeter - previousYInMillimeter;
+  return dx*dx + dy*dy > maxDistance * maxDistance;
+}
+
+void ClusterExtractor::startCluster(float angleInDegree, float rangeInMillimeter, float xInMillimeter, float yInMillimeter){
+  firstXInMillimeter = xInMillimeter;
+  firstYInMillimeter = yInMillimeter;
+  sumXInMillimeter = xInMillimeter;
+  sumYInMillimeter = yInMillimeter;
+  running.pointCount = 1;
+  running.startAngleInDegree = angleInDegree;
+  running.endAngleInDegree = angleInDegree;
+  running.nearestRangeInMillimeter = rangeInMillimeter;
+  running.nearestAngleInDegree = angleInDegree;
+}
+
+void ClusterExtractor::finishCluster(){
+  if(running.pointCount < minPoints){
+    return;
+  }
+  if(clusterCount >= maxClusters){
+    droppedClusterCount++;
+    return;
+  }
+  running.centroidXInMillimeter = sumXInMillimeter / running.pointCount;
+  running.centroidYInMillimeter = sumYInMillimeter / running.pointCount;
+  float dx = previousXInMillimeter - firstXInMillimeter;
+  float dy = previousYInMillimeter - firstYInMillimeter;
+  running.widthInMillimeter = sqrtf(dx*dx + dy*dy);
+  clusters[clusterCount++] = running;
+}
+
+size_t ClusterExtractor::finishRevolution(){
+  size_t count = 0;
+  if(hasRevolutionStart){
+    if(hasPreviousPoint){
+      finishCluster();
+    }
+    count = clusterCount;
+    if(handler != nullptr){
+      handler->operator()(clusters, count);
+    }
+  }
+  clusterCount = 0;
+  hasPreviousPoint = false;
+  hasRevolutionStart = true;
+  return count;
+}
+
+unsigned long ClusterExtractor::getDroppedClusterCount(){
+  return droppedClusterCount;
+}
+
+} // end namespace
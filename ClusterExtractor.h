@@ -0,0 +1,94 @@
+#ifndef __CLUSTER_EXTRACTOR__
+#define __CLUSTER_EXTRACTOR__
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+
+namespace sensorYDLidarX4 {
+
+// one object of a revolution, x/y in the frame of the lidar
+struct LidarCluster{
+  float centroidXInMillimeter;
+  float centroidYInMillimeter;
+  float widthInMillimeter;       // distance between the first and the last point
+  float startAngleInDegree;
+  float endAngleInDegree;
+  float nearestRangeInMillimeter;
+  float nearestAngleInDegree;
+  uint16_t pointCount;
+};
+
+// called once per revolution (on the index packet) with the clusters of the finished one
+typedef std::function<void(const LidarCluster clusters[], size_t count)> OnLidarClustersHandler;
+
+/*
+groups neighbouring samples into objects with an adaptive breakpoint
+
+two neighbours belong to the same cluster if they are closer than
+
+  maxDistance = range * sin(angleStep) / sin(lambda - angleStep) + 3 * sigma
+
+(the distance a surface seen under the angle lambda would have, plus the noise),
+so the allowed gap grows with the range. the samples are added paket by paket in
+angle order, every cluster is accumulated in the same pass and only the finished
+ones are stored. at the index packet the clusters of the revolution are passed to
+the handler. the first revolution after start is incomplete and dropped, an
+object across 0 degree gives two clusters. no heap is used, a
+revolution has up to maxClusters clusters, more are counted as dropped.
+
+  static ClusterExtractor clusterExtractor;
+  static OnLidarClustersHandler onClusters = [](const LidarCluster clusters[], size_t count){ ... };
+  clusterExtractor.setHandler(onClusters);
+  YDLidarX4::builder().setClusterExtractor(clusterExtractor)...
+*/
+
+class ClusterExtractor{
+  public:
+    const static size_t maxClusters = 64;
+
+  private:
+    LidarCluster clusters[maxClusters];
+    size_t clusterCount;
+    unsigned long droppedClusterCount;
+    OnLidarClustersHandler *handler;
+    bool hasRevolutionStart;
+
+    float lambdaInRad;
+    float sigmaInMillimeter;
+    uint16_t minPoints;
+
+    // the running cluster
+    bool hasPreviousPoint;
+    float previousXInMillimeter;
+    float previousYInMillimeter;
+    float previousRangeInMillimeter;
+    float previousAngleInDegree;
+    float firstXInMillimeter;
+    float firstYInMillimeter;
+    float sumXInMillimeter;
+    float sumYInMillimeter;
+    LidarCluster running;
+
+    bool isBreakpoint(float angleInDegree, float xInMillimeter, float yInMillimeter);
+    void startCluster(float angleInDegree, float rangeInMillimeter, float xInMillimeter, float yInMillimeter);
+    void finishCluster();
+
+  public:
+    ClusterExtractor();
+    void setHandler(OnLidarClustersHandler &handler);
+    void setBreakpoint(float lambdaInDegree, float sigmaInMillimeter);
+    void setMinPoints(uint16_t minPoints);
+    void reset();
+
+    // samples in angle order, ranges <= 0 are skipped
+    void add(const float anglesInDegree[], const float rangesInMillimeter[], size_t lenght);
+    // ends the revolution, calls the handler and returns the cluster count (0 for the first one)
+    size_t finishRevolution();
+
+    unsigned long getDroppedClusterCount();
+};
+
+} // end namespace
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef __DECIMATION_MODE__
+#define __DECIMATION_MODE__
+
+namespace sensorYDLidarX4{
+
+enum DecimationMode{
+  DECIMATION_NONE,
+  DECIMATION_EVERY_NTH,         // every nth sample, counted across pakets
+  DECIMATION_NEAREST_IN_SECTOR, // the valid sample closest to the center of each sector
+  DECIMATION_MIN_RANGE_IN_SECTOR // the shortest valid range of each sector
+};
+
+} // end namespace
+
+#endif
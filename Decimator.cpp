@@ -0,0 +1,131 @@
+#include <Decimator.h>
+#include <cmath>
+
+namespace sensorYDLidarX4 {
+
+Decimator::Decimator()
+  : mode(DECIMATION_NONE),
+  everyNth(1),
+  sectorInQ16Degree(1 << 16)
+{
+  reset();
+}
+
+void Decimator::setEveryNth(size_t everyNth){
+  this->mode = DECIMATION_EVERY_NTH;
+  this->everyNth = everyNth > 0 ? everyNth : 1;
+  reset();
+}
+
+// the sector size should divide 360 degree, otherwise the last sector is smaller
+void Decimator::setSectorMode(DecimationMode mode, float sectorInDegree){
+  this->mode = mode;
+  int32_t sector = lround(sectorInDegree * 65536);
+  this->sectorInQ16Degree = sector > 0 ? sector : 1;
+  reset();
+}
+
+void Decimator::disable(){
+  mode = DECIMATION_NONE;
+}
+
+bool Decimator::isEnabled(){
+  return mode != DECIMATION_NONE;
+}
+
+void Decimator::reset(){
+  sampleCounter = 0;
+  hasPendingSample = false;
+  inputSampleCount = 0;
+  outputSampleCount = 0;
+}
+
+size_t Decimator::decimate(const int32_t anglesInQ16Degree[], const uint16_t distances[], size_t lenght, int32_t decimatedAnglesInQ16Degree[], uint16_t decimatedDistances[]){
+  size_t decimatedLenght;
+  switch(mode){
+    case DECIMATION_EVERY_NTH:
+      decimatedLenght = decimateEveryNth(anglesInQ16Degree, distances, lenght, decimatedAnglesInQ16Degree, decimatedDistances);
+      break;
+    case DECIMATION_NEAREST_IN_SECTOR:
+    case DECIMATION_MIN_RANGE_IN_SECTOR:
+      decimatedLenght = decimateSectors(anglesInQ16Degree, distances, lenght, decimatedAnglesInQ16Degree, decimatedDistances);
+      break;
+    default:
+      for(size_t sampleNum=0; sampleNum<lenght; sampleNum++){
+        decimatedAnglesInQ16Degree[sampleNum] = anglesInQ16Degree[sampleNum];
+        decimatedDistances[sampleNum] = distances[sampleNum];
+      }
+      decimatedLenght = lenght;
+  }
+  inputSampleCount += lenght;
+  outputSampleCount += decimatedLenght;
+  return decimatedLenght;
+}
+
+size_t Decimator::decimateEveryNth(const int32_t anglesInQ16Degree[], const uint16_t distances[], size_t lenght, int32_t decimatedAnglesInQ16Degree[], uint16_t decimatedDistances[]){
+  size_t decimatedLenght = 0;
+  for(size_t sampleNum=0; sampleNum<lenght; sampleNum++){
+    if(sampleCounter == 0){
+      decimatedAnglesInQ16Degree[decimatedLenght] = anglesInQ16Degree[sampleNum];
+      decimatedDistances[decimatedLenght] = distances[sampleNum];
+      decimatedLenght++;
+    }
+    sampleCounter = sampleCounter+1 < everyNth ? sampleCounter+1 : 0;
+  }
+  return decimatedLenght;
+}
+
+// lower is better, an invalid range (0) is always worse than any valid one
+uint32_t Decimator::rank(int32_t angleInQ16Degree, int32_t sector, uint16_t distance){
+  uint32_t invalid = distance == 0 ? 0x80000000u : 0;
+  if(mode == DECIMATION_MIN_RANGE_IN_SECTOR && distance != 0){
+    return distance;
+  }
+  int32_t offsetFromCenter = angleInQ16Degree - (sector * sectorInQ16Degree + sectorInQ16Degree/2);
+  return invalid | (uint32_t)(offsetFromCenter < 0 ? -offsetFromCenter : offsetFromCenter);
+}
+
+size_t Decimator::decimateSectors(const int32_t anglesInQ16Degree[], const uint16_t distances[], size_t lenght, int32_t decimatedAnglesInQ16Degree[], uint16_t decimatedDistances[]){
+  size_t decimatedLenght = 0;
+  for(size_t sampleNum=0; sampleNum<lenght; sampleNum++){
+    int32_t angle = anglesInQ16Degree[sampleNum];
+    int32_t sector = angle / sectorInQ16Degree;
+    uint32_t sampleRank = rank(angle, sector, distances[sampleNum]);
+
+    if(hasPendingSample && sector != pendingSector){
+      decimatedAnglesInQ16Degree[decimatedLenght] = pendingAngleInQ16Degree;
+      decimatedDistances[decimatedLenght] = pendingDistance;
+      decimatedLenght++;
+      hasPendingSample = false;
+    }
+    if(!hasPendingSample || sampleRank < pendingRank){
+      hasPendingSample = true;
+      pendingSector = sector;
+      pendingAngleInQ16Degree = angle;
+      pendingDistance = distances[sampleNum];
+      pendingRank = sampleRank;
+    }
+  }
+  return decimatedLenght;
+}
+
+size_t Decimator::flush(int32_t decimatedAnglesInQ16Degree[], uint16_t decimatedDistances[]){
+  if(!hasPendingSample){
+    return 0;
+  }
+  decimatedAnglesInQ16Degree[0] = pendingAngleInQ16Degree;
+  decimatedDistances[0] = pendingDistance;
+  hasPendingSample = false;
+  outputSampleCount++;
+  return 1;
+}
+
+unsigned long Decimator::getInputSampleCount(){
+  return inputSampleCount;
+}
+
+unsigned long Decimator::getOutputSampleCount(){
+  return outputSampleCount;
+}
+
+} // end namespace
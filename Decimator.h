@@ -0,0 +1,67 @@
+#ifndef __DECIMATOR__
+#define __DECIMATOR__
+
+#include <cstdint>
+#include <cstddef>
+#include <DecimationMode.h>
+
+namespace sensorYDLidarX4 {
+
+/*
+reduces the samples before they are converted
+
+works on the uncorrected angles (1/65536 degree) and the raw distances, so the
+dropped samples never reach the angle correction or the float conversion.
+a sector is finished with the first sample of the next sector, so its sample is
+delivered with the paket which finishes it. every sample finishes at most one
+sector, so a paket never delivers more samples than it has. the last sector of a
+revolution is delivered by flush() before the index paket. a sector without any
+valid range delivers one sample with range 0.
+
+  static Decimator decimator;
+  decimator.setSectorMode(DECIMATION_MIN_RANGE_IN_SECTOR, 2);   // 180 samples/revolution
+  YDLidarX4::builder().setDecimator(decimator)...
+*/
+
+class Decimator{
+  private:
+    const static int32_t fullCircleInQ16Degree = 360 << 16;
+
+    DecimationMode mode;
+    size_t everyNth;
+    int32_t sectorInQ16Degree;
+
+    size_t sampleCounter;
+    bool hasPendingSample;
+    int32_t pendingSector;
+    int32_t pendingAngleInQ16Degree;
+    uint16_t pendingDistance;
+    uint32_t pendingRank;
+
+    unsigned long inputSampleCount;
+    unsigned long outputSampleCount;
+
+    size_t decimateEveryNth(const int32_t anglesInQ16Degree[], const uint16_t distances[], size_t lenght, int32_t decimatedAnglesInQ16Degree[], uint16_t decimatedDistances[]);
+    size_t decimateSectors(const int32_t anglesInQ16Degree[], const uint16_t distances[], size_t lenght, int32_t decimatedAnglesInQ16Degree[], uint16_t decimatedDistances[]);
+    uint32_t rank(int32_t angleInQ16Degree, int32_t sector, uint16_t distance);
+
+  public:
+    Decimator();
+    void setEveryNth(size_t everyNth);
+    void setSectorMode(DecimationMode mode, float sectorInDegree);
+    void disable();
+    bool isEnabled();
+    void reset();
+
+    // angles in [0, 360) degree, the outputs need lenght elements. returns the kept sample count
+    size_t decimate(const int32_t anglesInQ16Degree[], const uint16_t distances[], size_t lenght, int32_t decimatedAnglesInQ16Degree[], uint16_t decimatedDistances[]);
+    // the pending sample of the running sector (0 or 1 sample), e.g. at the end of a revolution
+    size_t flush(int32_t decimatedAnglesInQ16Degree[], uint16_t decimatedDistances[]);
+
+    unsigned long getInputSampleCount();
+    unsigned long getOutputSampleCount();
+};
+
+} // end namespace
+
+#endif
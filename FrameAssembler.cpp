@@ -0,0 +1,74 @@
+#include <FrameAssembler.h>
+#include <cstring>
+
+using std::memcpy;
+
+namespace sensorYDLidarX4 {
+
+FrameAssembler::FrameAssembler(size_t maxSamplesPerFrame)
+  : currentFrame(&frames[0]),
+  hasRevolutionStart(false),
+  frameCount(0)
+{
+  for(LidarFrame &frame : frames){
+    frame.anglesInDegree = new float[maxSamplesPerFrame];
+    frame.rangesInMillimeter = new float[maxSamplesPerFrame];
+    frame.capacity = maxSamplesPerFrame;
+    frame.sequence = 0;
+    clearFrame(frame);
+  }
+}
+
+FrameAssembler::~FrameAssembler(){
+  for(LidarFrame &frame : frames){
+    delete[] frame.anglesInDegree;
+    delete[] frame.rangesInMillimeter;
+  }
+}
+
+void FrameAssembler::clearFrame(LidarFrame &frame){
+  frame.size = 0;
+  frame.droppedSamples = 0;
+  frame.startTimeInMicros = 0;
+  frame.endTimeInMicros = 0;
+}
+
+void FrameAssembler::reset(){
+  clearFrame(*currentFrame);
+  hasRevolutionStart = false;
+  frameCount = 0;
+}
+
+LidarFrame* FrameAssembler::startRevolution(){
+  LidarFrame *finishedFrame = nullptr;
+  if(hasRevolutionStart && currentFrame->size > 0){
+    finishedFrame = currentFrame;
+    finishedFrame->sequence = frameCount++;
+    currentFrame = finishedFrame == &frames[0] ? &frames[1] : &frames[0];
+  }
+  clearFrame(*currentFrame);
+  hasRevolutionStart = true;
+  return finishedFrame;
+}
+
+void FrameAssembler::add(float anglesInDegree[], float rangesInMillimeter[], size_t lenght, unsigned long firstSampleTimeInMicros, unsigned long lastSampleTimeInMicros){
+  if(!hasRevolutionStart){
+    return;
+  }
+  if(currentFrame->size == 0){
+    currentFrame->startTimeInMicros = firstSampleTimeInMicros;
+  }
+  currentFrame->endTimeInMicros = lastSampleTimeInMicros;
+  size_t freeSamples = currentFrame->capacity - currentFrame->size;
+  size_t samplesToCopy = lenght < freeSamples ? lenght : freeSamples;
+  memcpy(&currentFrame->anglesInDegree[currentFrame->size], anglesInDegree, samplesToCopy * sizeof(float));
+  memcpy(&currentFrame->rangesInMillimeter[currentFrame->size], rangesInMillimeter, samplesToCopy * sizeof(float));
+  currentFrame->size += samplesToCopy;
+  currentFrame->droppedSamples += lenght - samplesToCopy;
+}
+
+size_t FrameAssembler::getCapacity(){
+  return currentFrame->capacity;
+}
+
+} // end namespace
@@ -0,0 +1,54 @@
+#ifndef __FRAME_ASSEMBLER__
+#define __FRAME_ASSEMBLER__
+
+#include <cstddef>
+
+namespace sensorYDLidarX4 {
+
+// one full revolution, beginning with the sample of the index packet
+struct LidarFrame{
+  float *anglesInDegree;
+  float *rangesInMillimeter;
+  size_t size;
+  size_t capacity;
+  unsigned long sequence;       // counts the frames since start
+  unsigned long droppedSamples; // samples which did not fit into the frame
+  unsigned long startTimeInMicros; // time of the first and the last sample
+  unsigned long endTimeInMicros;
+};
+
+/*
+collects the samples of the scan pakets into full revolutions
+
+the index packet is the revolution boundary. the samples go into a
+preallocated frame, at the boundary the frames are swapped and the
+finished one is returned. it stays untouched until the next revolution
+is finished, so a consumer can work on it while the parser fills the
+other buffer. the first revolution after start is incomplete and dropped.
+*/
+
+class FrameAssembler{
+  private:
+    LidarFrame frames[2];
+    LidarFrame *currentFrame;
+    bool hasRevolutionStart;
+    unsigned long frameCount;
+
+    void clearFrame(LidarFrame &frame);
+
+  public:
+    FrameAssembler(size_t maxSamplesPerFrame);
+    ~FrameAssembler();
+    FrameAssembler(const FrameAssembler&) = delete;
+    FrameAssembler& operator=(const FrameAssembler&) = delete;
+
+    void reset();
+    // call it on every index packet before adding its samples, returns the finished frame or nullptr
+    LidarFrame* startRevolution();
+    void add(float anglesInDegree[], float rangesInMillimeter[], size_t lenght, unsigned long firstSampleTimeInMicros, unsigned long lastSampleTimeInMicros);
+    size_t getCapacity();
+};
+
+} // end namespace
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef __LIDAR_QUEUE__
+#define __LIDAR_QUEUE__
+
+#include <cstddef>
+
+namespace sensorYDLidarX4 {
+
+/*
+read-only view over the first elements of a queue,
+split into two segments if the elements wrap around the end of the ring
+*/
+
+template <typename Type>
+struct LidarQueueView{
+  const Type *first;
+  size_t firstSize;
+  const Type *second;
+  size_t secondSize;
+
+  Type operator[](size_t index) const{
+    return index < firstSize ? first[index] : second[index-firstSize];
+  }
+
+  size_t size() const{
+    return firstSize + secondSize;
+  }
+};
+
+/*
+common interface of all queues between the serial receiver (producer)
+and the state machine (consumer)
+*/
+
+template <typename Type>
+class LidarQueue{
+  public:
+    virtual ~LidarQueue(){}
+    virtual bool add(Type element) = 0;
+    virtual bool add(Type *elements, size_t size) = 0;
+    // producer side bulk write: reserve a contiguous span (up to the wrap point), fill it, commit it
+    virtual size_t reserve(Type *&span) = 0;
+    virtual void commit(size_t size) = 0;
+    virtual Type get(size_t index) = 0;
+    virtual Type getRaw(size_t index) = 0;
+    virtual Type dequeue() = 0;
+    virtual bool extract(Type *targetBuffer, size_t size) = 0;
+    // copy up to size elements beginning at offset without removing them, returns the copied count
+    virtual size_t peek(size_t offset, Type *targetBuffer, size_t size) = 0;
+    // consumer side zero copy read: the view stays valid until the elements are removed
+    virtual bool view(size_t size, LidarQueueView<Type> &view) = 0;
+    virtual void remove(size_t sizeToRemove) = 0;
+    virtual void clear() = 0;
+    virtual bool isFull() = 0;
+    virtual bool isEmpty() = 0;
+    virtual size_t size() = 0;
+    virtual size_t getCapacity() = 0;
+    virtual size_t getHead() = 0;
+    virtual size_t getTail() = 0;
+};
+
+} // end namespace
+
+#endif
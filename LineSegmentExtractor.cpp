@@ -0,0 +1,221 @@
+#include <LineSegmentExtractor.h>
+#include <cmath>
+
+namespace sensorYDLidarX4 {
+
+LineSegmentExtractor::LineSegmentExtractor(size_t maxPoints, size_t maxSegments)
+  : maxPoints(maxPoints),
+  maxSegments(maxSegments),
+  segmentCount(0),
+  jumpDistanceInMillimeter(150),
+  splitThresholdInMillimeter(30),
+  minLengthInMillimeter(200),
+  minPoints(6)
+{
+  xInMillimeter = new float[maxPoints];
+  yInMillimeter = new float[maxPoints];
+  ranges = new PointRange[maxPoints];
+  segmentRanges = new PointRange[maxSegments];
+  segments = new LineSegment[maxSegments];
+}
+
+LineSegmentExtractor::~LineSegmentExtractor(){
+  delete[] xInMillimeter;
+  delete[] yInMillimeter;
+  delete[] ranges;
+  delete[] segmentRanges;
+  delete[] segments;
+}
+
+void LineSegmentExtractor::setJumpDistance(float jumpDistanceInMillimeter){
+  this->jumpDistanceInMillimeter = jumpDistanceInMillimeter;
+}
+
+void LineSegmentExtractor::setSplitThreshold(float splitThresholdInMillimeter){
+  this->splitThresholdInMillimeter = splitThresholdInMillimeter;
+}
+
+void LineSegmentExtractor::setMinLength(float minLengthInMillimeter){
+  this->minLengthInMillimeter = minLengthInMillimeter;
+}
+
+// at least 2 points are needed for a line
+void LineSegmentExtractor::setMinPoints(size_t minPoints){
+  this->minPoints = minPoints > 2 ? minPoints : 2;
+}
+
+size_t LineSegmentExtractor::extract(const LidarFrame &frame){
+  return extract(frame.anglesInDegree, frame.rangesInMillimeter, frame.size);
+}
+
+size_t LineSegmentExtractor::extract(const float anglesInDegree[], const float rangesInMillimeter[], size_t lenght){
+  const float toRad = 3.14159265359f / 180;
+  size_t pointCount = 0;
+  for(size_t sampleNum=0; sampleNum<lenght && pointCount<maxPoints; sampleNum++){
+    float range = rangesInMillimeter[sampleNum];
+    if(range <= 0){
+      continue;
+    }
+    float angle = anglesInDegree[sampleNum] * toRad;
+    xInMillimeter[pointCount] = range * cosf(angle);
+    yInMillimeter[pointCount] = range * sinf(angle);
+    pointCount++;
+  }
+
+  segmentCount = 0;
+  float jumpDistanceSquared = jumpDistanceInMillimeter * jumpDistanceInMillimeter;
+  size_t runStart = 0;
+  for(size_t pointNum=1; pointNum<=pointCount; pointNum++){
+    bool isRunEnd = pointNum == pointCount;
+    if(!isRunEnd){
+      float dx = xInMillimeter[pointNum] - xInMillimeter[pointNum-1];
+      float dy = yInMillimeter[pointNum] - yInMillimeter[pointNum-1];
+      isRunEnd = dx*dx + dy*dy > jumpDistanceSquared;
+    }
+    if(isRunEnd){
+      if(pointNum - runStart >= minPoints){
+        splitRun(runStart, pointNum-1);
+      }
+      runStart = pointNum;
+    }
+  }
+  return segmentCount;
+}
+
+// iterative end point fit with an explicit stack, the left part first so the segments stay in angle order
+void LineSegmentExtractor::splitRun(size_t first, size_t last){
+  size_t stackSize = 0;
+  ranges[stackSize++] = {first, last};
+  while(stackSize > 0){
+    PointRange range = ranges[--stackSize];
+    if(range.last - range.first + 1 < minPoints){
+      continue;
+    }
+    float maxDistance;
+    size_t splitPoint = furthestPoint(range.first, range.last, maxDistance);
+    if(maxDistance > splitThresholdInMillimeter && stackSize+2 <= maxPoints){
+      // the split point is the end of the left and the start of the right part
+      ranges[stackSize++] = {splitPoint, range.last};
+      ranges[stackSize++] = {range.first, splitPoint};
+    }else{
+      addSegment(range.first, range.last);
+    }
+  }
+}
+
+size_t LineSegmentExtractor::furthestPoint(size_t first, size_t last, float &maxDistance){
+  float startX = xInMillimeter[first];
+  float startY = yInMillimeter[first];
+  float dx = xInMillimeter[last] - startX;
+  float dy = yInMillimeter[last] - startY;
+  float chordLength = sqrtf(dx*dx + dy*dy);
+  float scale = chordLength > 0 ? 1 / chordLength : 0;
+
+  size_t furthest = first;
+  maxDistance = 0;
+  for(size_t pointNum=first+1; pointNum<last; pointNum++){
+    float px = xInMillimeter[pointNum] - startX;
+    float py = yInMillimeter[pointNum] - startY;
+    float distance = chordLength > 0 ? fabsf(px*dy - py*dx) * scale : sqrtf(px*px + py*py);
+    if(distance > maxDistance){
+      maxDistance = distance;
+      furthest = pointNum;
+    }
+  }
+  return furthest;
+}
+
+// neighbouring parts of one run are merged, if their points fit into one line
+void LineSegmentExtractor::addSegment(size_t first, size_t last){
+  LineSegment segment;
+  if(segmentCount > 0 && segmentRanges[segmentCount-1].last == first){
+    size_t mergedFirst = segmentRanges[segmentCount-1].first;
+    if(fitLine(mergedFirst, last, segment) && maxDistanceToLine(mergedFirst, last, segment) <= splitThresholdInMillimeter){
+      segments[segmentCount-1] = segment;
+      segmentRanges[segmentCount-1].last = last;
+      return;
+    }
+  }
+  if(!fitLine(first, last, segment) || segment.lengthInMillimeter < minLengthInMillimeter || segmentCount >= maxSegments){
+    return;
+  }
+  segments[segmentCount] = segment;
+  segmentRanges[segmentCount] = {first, last};
+  segmentCount++;
+}
+
+// orthogonal regression: the line through the centroid along the main axis of the points
+bool LineSegmentExtractor::fitLine(size_t first, size_t last, LineSegment &segment){
+  size_t pointCount = last - first + 1;
+  if(pointCount < 2){
+    return false;
+  }
+  float meanX = 0;
+  float meanY = 0;
+  for(size_t pointNum=first; pointNum<=last; pointNum++){
+    meanX += xInMillimeter[pointNum];
+    meanY += yInMillimeter[pointNum];
+  }
+  meanX /= pointCount;
+  meanY /= pointCount;
+  float sxx = 0;
+  float syy = 0;
+  float sxy = 0;
+  for(size_t pointNum=first; pointNum<=last; pointNum++){
+    float dx = xInMillimeter[pointNum] - meanX;
+    float dy = yInMillimeter[pointNum] - meanY;
+    sxx += dx*dx;
+    syy += dy*dy;
+    sxy += dx*dy;
+  }
+  float normalAngle = 0.5f * atan2f(2*sxy, sxx - syy) + 3.14159265359f/2;
+  float normalX = cosf(normalAngle);
+  float normalY = sinf(normalAngle);
+  float distance = meanX*normalX + meanY*normalY;
+  if(distance < 0){
+    distance = -distance;
+    normalX = -normalX;
+    normalY = -normalY;
+    normalAngle += 3.14159265359f;
+  }
+
+  // the end points are projected onto the line
+  float startOffset = xInMillimeter[first]*normalX + yInMillimeter[first]*normalY - distance;
+  float endOffset = xInMillimeter[last]*normalX + yInMillimeter[last]*normalY - distance;
+  segment.startXInMillimeter = xInMillimeter[first] - startOffset*normalX;
+  segment.startYInMillimeter = yInMillimeter[first] - startOffset*normalY;
+  segment.endXInMillimeter = xInMillimeter[last] - endOffset*normalX;
+  segment.endYInMillimeter = yInMillimeter[last] - endOffset*normalY;
+  float dx = segment.endXInMillimeter - segment.startXInMillimeter;
+  float dy = segment.endYInMillimeter - segment.startYInMillimeter;
+  segment.lengthInMillimeter = sqrtf(dx*dx + dy*dy);
+  float normalAngleInDegree = normalAngle * (180 / 3.14159265359f);
+  segment.normalAngleInDegree = normalAngleInDegree >= 360 ? normalAngleInDegree - 360 : (normalAngleInDegree < 0 ? normalAngleInDegree + 360 : normalAngleInDegree);
+  segment.distanceInMillimeter = distance;
+  segment.pointCount = pointCount;
+  return true;
+}
+
+float LineSegmentExtractor::maxDistanceToLine(size_t first, size_t last, const LineSegment &segment){
+  const float toRad = 3.14159265359f / 180;
+  float normalX = cosf(segment.normalAngleInDegree * toRad);
+  float normalY = sinf(segment.normalAngleInDegree * toRad);
+  float maxDistance = 0;
+  for(size_t pointNum=first; pointNum<=last; pointNum++){
+    float distance = fabsf(xInMillimeter[pointNum]*normalX + yInMillimeter[pointNum]*normalY - segment.distanceInMillimeter);
+    if(distance > maxDistance){
+      maxDistance = distance;
+    }
+  }
+  return maxDistance;
+}
+
+const LineSegment* LineSegmentExtractor::getSegments(){
+  return segments;
+}
+
+size_t LineSegmentExtractor::getSegmentCount(){
+  return segmentCount;
+}
+
+} // end namespace
@@ -0,0 +1,91 @@
+#ifndef __LINE_SEGMENT_EXTRACTOR__
+#define __LINE_SEGMENT_EXTRACTOR__
+
+#include <cstddef>
+#include <FrameAssembler.h>
+
+namespace sensorYDLidarX4 {
+
+// x/y in the frame of the lidar, the line in hesse normal form: x*cos(normal) + y*sin(normal) = distance
+struct LineSegment{
+  float startXInMillimeter;
+  float startYInMillimeter;
+  float endXInMillimeter;
+  float endYInMillimeter;
+  float normalAngleInDegree;
+  float distanceInMillimeter;
+  float lengthInMillimeter;
+  size_t pointCount;
+};
+
+/*
+split and merge line extraction on a full revolution
+
+  1. the samples with a range are converted to x/y in angle order
+  2. neighbours further apart than the jump distance split the scan into runs
+  3. iterative end point fit: a run is split at the point furthest from the line
+     between its end points as long as that distance is above the split threshold
+  4. each part is refined with a least squares fit (orthogonal regression),
+     neighbouring parts which fit into one line again are merged
+
+all buffers are allocated once in the constructor, extract() never allocates.
+segments shorter than the min length or with less than min points are dropped.
+the scan is not closed at the index packet, a wall across 0 degree gives two segments.
+
+  static LineSegmentExtractor lineSegmentExtractor(1024, 64);
+  static OnLidarFrameHandler onFrame = [](LidarFrame &frame){
+    size_t count = lineSegmentExtractor.extract(frame);
+    const LineSegment *segments = lineSegmentExtractor.getSegments();
+    ...
+  };
+*/
+
+class LineSegmentExtractor{
+  private:
+    struct PointRange{
+      size_t first;
+      size_t last;
+    };
+
+    size_t maxPoints;
+    size_t maxSegments;
+    float *xInMillimeter;
+    float *yInMillimeter;
+    PointRange *ranges;
+    PointRange *segmentRanges;
+    LineSegment *segments;
+    size_t segmentCount;
+
+    float jumpDistanceInMillimeter;
+    float splitThresholdInMillimeter;
+    float minLengthInMillimeter;
+    size_t minPoints;
+
+    void splitRun(size_t first, size_t last);
+    size_t furthestPoint(size_t first, size_t last, float &maxDistance);
+    bool fitLine(size_t first, size_t last, LineSegment &segment);
+    float maxDistanceToLine(size_t first, size_t last, const LineSegment &segment);
+    void addSegment(size_t first, size_t last);
+
+  public:
+    LineSegmentExtractor(size_t maxPoints, size_t maxSegments);
+    ~LineSegmentExtractor();
+    LineSegmentExtractor(const LineSegmentExtractor&) = delete;
+    LineSegmentExtractor& operator=(const LineSegmentExtractor&) = delete;
+
+    void setJumpDistance(float jumpDistanceInMillimeter);
+    void setSplitThreshold(float splitThresholdInMillimeter);
+    void setMinLength(float minLengthInMillimeter);
+    void setMinPoints(size_t minPoints);
+
+    // returns the segment count, samples above maxPoints are ignored
+    size_t extract(const LidarFrame &frame);
+    size_t extract(const float anglesInDegree[], const float rangesInMillimeter[], size_t lenght);
+
+    const LineSegment* getSegments();
+    size_t getSegmentCount();
+};
+
+} // end namespace
+
+#endif
@@ -0,0 +1,264 @@
+#ifndef __LOCK_FREE_QUEUE__
+#define __LOCK_FREE_QUEUE__
+
+#include <atomic>
+#include <cstring>
+#include <LidarQueue.h>
+using std::memcpy;
+
+namespace sensorYDLidarX4 {
+
+/*
+single producer / single consumer ring without any lock
+
+the producer (serial receive callback) only moves the tail,
+the consumer (state machine) only moves the head.
+one slot always stays free to tell a full ring from an empty one.
+
+producer side: add, reserve, commit
+consumer side: get, dequeue, extract, peek, view, remove, clear
+*/
+
+template <typename Type>
+class LockFreeQueue : public LidarQueue<Type>{
+  private:
+    size_t maxElements;
+    size_t slots;
+    Type* buffer;
+    std::atomic<size_t> head;
+    std::atomic<size_t> tail;
+
+    size_t wrap(size_t);
+    size_t count(size_t head, size_t tail);
+
+  public:
+    LockFreeQueue(size_t maxElements);
+    ~LockFreeQueue();
+    bool add(Type element);
+    bool add(Type *elements, size_t size);
+    size_t reserve(Type *&span);
+    void commit(size_t size);
+    Type get(size_t index);
+    Type getRaw(size_t index);
+    Type dequeue();
+    bool extract(Type *targetBuffer, size_t size);
+    size_t peek(size_t offset, Type *targetBuffer, size_t size);
+    bool view(size_t size, LidarQueueView<Type> &view);
+    void remove(size_t sizeToRemove);
+    void clear();
+    bool isFull();
+    bool isEmpty();
+    size_t size();
+    size_t getCapacity();
+    size_t getHead();
+    size_t getTail();
+};
+
+template <typename Type>
+LockFreeQueue<Type>::LockFreeQueue(size_t elementCount)
+  : maxElements(elementCount),
+  slots(elementCount+1),
+  head(0),
+  tail(0)
+{
+  buffer = new Type[slots];
+}
+
+template <typename Type>
+LockFreeQueue<Type>::~LockFreeQueue(){
+  delete[] buffer;
+}
+
+// all indices are < 2*slots, so a compare replaces the modulo
+template <typename Type>
+inline size_t LockFreeQueue<Type>::wrap(size_t index){
+  return index >= slots ? index - slots : index;
+}
+
+template <typename Type>
+inline size_t LockFreeQueue<Type>::count(size_t head, size_t tail){
+  return tail >= head ? tail - head : tail + slots - head;
+}
+
+template <typename Type>
+bool LockFreeQueue<Type>::add(Type element){
+  size_t currentTail = tail.load(std::memory_order_relaxed);
+  size_t nextTail = wrap(currentTail + 1);
+  if(nextTail == head.load(std::memory_order_acquire)){
+    return false;
+  }
+  buffer[currentTail] = element;
+  tail.store(nextTail, std::memory_order_release);
+  return true;
+}
+
+template <typename Type>
+bool LockFreeQueue<Type>::add(Type *elements, size_t size){
+  size_t currentTail = tail.load(std::memory_order_relaxed);
+  size_t currentHead = head.load(std::memory_order_acquire);
+  if(count(currentHead, currentTail) + size > maxElements){
+    return false;
+  }
+  size_t sizeOfFirstPart = slots - currentTail;
+  if(size <= sizeOfFirstPart){
+    memcpy(&buffer[currentTail], &elements[0], size * sizeof(Type));
+  }else{
+    memcpy(&buffer[currentTail], &elements[0], sizeOfFirstPart * sizeof(Type));
+    memcpy(&buffer[0], &elements[sizeOfFirstPart], (size - sizeOfFirstPart) * sizeof(Type));
+  }
+  tail.store(wrap(currentTail + size), std::memory_order_release);
+  return true;
+}
+
+template <typename Type>
+size_t LockFreeQueue<Type>::reserve(Type *&span){
+  size_t currentTail = tail.load(std::memory_order_relaxed);
+  size_t currentHead = head.load(std::memory_order_acquire);
+  size_t freeElements = maxElements - count(currentHead, currentTail);
+  size_t elementsUntilWrap = slots - currentTail;
+  span = &buffer[currentTail];
+  return freeElements < elementsUntilWrap ? freeElements : elementsUntilWrap;
+}
+
+template <typename Type>
+void LockFreeQueue<Type>::commit(size_t size){
+  size_t currentTail = tail.load(std::memory_order_relaxed);
+  tail.store(wrap(currentTail + size), std::memory_order_release);
+}
+
+template <typename Type>
+Type LockFreeQueue<Type>::get(size_t index){
+  Type element = Type();
+  size_t currentHead = head.load(std::memory_order_relaxed);
+  size_t currentTail = tail.load(std::memory_order_acquire);
+  if(index < count(currentHead, currentTail)){
+    element = buffer[wrap(currentHead + index)];
+  }
+  return element;
+}
+
+template <typename Type>
+Type LockFreeQueue<Type>::getRaw(size_t index){
+  return buffer[index % slots];
+}
+
+template <typename Type>
+Type LockFreeQueue<Type>::dequeue(){
+  Type element = Type();
+  size_t currentHead = head.load(std::memory_order_relaxed);
+  if(currentHead != tail.load(std::memory_order_acquire)){
+    element = buffer[currentHead];
+    head.store(wrap(currentHead + 1), std::memory_order_release);
+  }
+  return element;
+}
+
+template <typename Type>
+bool LockFreeQueue<Type>::extract(Type *targetBuffer, size_t size){
+  size_t currentHead = head.load(std::memory_order_relaxed);
+  size_t currentTail = tail.load(std::memory_order_acquire);
+  if(size > count(currentHead, currentTail)){
+    return false;
+  }
+  size_t sizeOfFirstPart = slots - currentHead;
+  if(size <= sizeOfFirstPart){
+    // normal - one block
+    memcpy(&targetBuffer[0], &buffer[currentHead], size * sizeof(Type));
+  }else{
+    // with wrap around - two blocks
+    memcpy(&targetBuffer[0], &buffer[currentHead], sizeOfFirstPart * sizeof(Type));
+    memcpy(&targetBuffer[sizeOfFirstPart], &buffer[0], (size - sizeOfFirstPart) * sizeof(Type));
+  }
+  head.store(wrap(currentHead + size), std::memory_order_release);
+  return true;
+}
+
+template <typename Type>
+size_t LockFreeQueue<Type>::peek(size_t offset, Type *targetBuffer, size_t size){
+  size_t currentHead = head.load(std::memory_order_relaxed);
+  size_t currentTail = tail.load(std::memory_order_acquire);
+  size_t currentCount = count(currentHead, currentTail);
+  if(offset >= currentCount){
+    return 0;
+  }
+  size_t peekedSize = currentCount-offset < size ? currentCount-offset : size;
+  size_t start = wrap(currentHead + offset);
+  size_t sizeOfFirstPart = slots - start;
+  if(peekedSize <= sizeOfFirstPart){
+    memcpy(&targetBuffer[0], &buffer[start], peekedSize * sizeof(Type));
+  }else{
+    memcpy(&targetBuffer[0], &buffer[start], sizeOfFirstPart * sizeof(Type));
+    memcpy(&targetBuffer[sizeOfFirstPart], &buffer[0], (peekedSize - sizeOfFirstPart) * sizeof(Type));
+  }
+  return peekedSize;
+}
+
+template <typename Type>
+bool LockFreeQueue<Type>::view(size_t size, LidarQueueView<Type> &view){
+  size_t currentHead = head.load(std::memory_order_relaxed);
+  size_t currentTail = tail.load(std::memory_order_acquire);
+  if(size > count(currentHead, currentTail)){
+    return false;
+  }
+  size_t sizeOfFirstPart = slots - currentHead;
+  view.first = &buffer[currentHead];
+  view.second = &buffer[0];
+  if(size <= sizeOfFirstPart){
+    view.firstSize = size;
+    view.secondSize = 0;
+  }else{
+    view.firstSize = sizeOfFirstPart;
+    view.secondSize = size - sizeOfFirstPart;
+  }
+  return true;
+}
+
+template <typename Type>
+void LockFreeQueue<Type>::remove(size_t sizeToRemove){
+  size_t currentHead = head.load(std::memory_order_relaxed);
+  size_t currentTail = tail.load(std::memory_order_acquire);
+  if(sizeToRemove <= count(currentHead, currentTail)){
+    head.store(wrap(currentHead + sizeToRemove), std::memory_order_release);
+  }
+}
+
+template <typename Type>
+void LockFreeQueue<Type>::clear(){
+  head.store(tail.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+template <typename Type>
+bool LockFreeQueue<Type>::isFull(){
+  return size() == maxElements;
+}
+
+template <typename Type>
+bool LockFreeQueue<Type>::isEmpty(){
+  return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+}
+
+template <typename Type>
+size_t LockFreeQueue<Type>::size(){
+  size_t currentHead = head.load(std::memory_order_acquire);
+  size_t currentTail = tail.load(std::memory_order_acquire);
+  return count(currentHead, currentTail);
+}
+
+template <typename Type>
+size_t LockFreeQueue<Type>::getCapacity(){
+  return maxElements;
+}
+
+template <typename Type>
+size_t LockFreeQueue<Type>::getHead(){
+  return head.load(std::memory_order_relaxed);
+}
+
+template <typename Type>
+size_t LockFreeQueue<Type>::getTail(){
+  return tail.load(std::memory_order_relaxed);
+}
+
+} // end namespace
+
+#endif
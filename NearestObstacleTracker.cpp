@@ -0,0 +1,174 @@
+#include <NearestObstacleTracker.h>
+
+namespace sensorYDLidarX4 {
+
+NearestObstacleTracker::NearestObstacleTracker(size_t sectorCount)
+  : sectorCount(sectorCount == 0 ? 1 : (sectorCount > maxSectors ? maxSectors : sectorCount)),
+  thresholdInQuarterMillimeter(0),
+  hysteresisInQuarterMillimeter(0),
+  handler(nullptr),
+  lock(xSemaphoreCreateMutex())
+{
+  clear();
+}
+
+NearestObstacleTracker::~NearestObstacleTracker(){
+  vSemaphoreDelete(lock);
+}
+
+// a threshold of 0 disables the events
+void NearestObstacleTracker::setThreshold(float thresholdInMillimeter, float hysteresisInMillimeter){
+  thresholdInQuarterMillimeter = thresholdInMillimeter*4 < UINT16_MAX ? thresholdInMillimeter*4 : UINT16_MAX;
+  hysteresisInQuarterMillimeter = hysteresisInMillimeter*4 < UINT16_MAX ? hysteresisInMillimeter*4 : UINT16_MAX;
+}
+
+void NearestObstacleTracker::setHandler(OnNearestObstacleHandler &handler){
+  this->handler = &handler;
+}
+
+void NearestObstacleTracker::update(const uint16_t anglesInQ6Degree[], const uint16_t rangesInQuarterMillimeter[], size_t lenght){
+  uint32_t changedSectors = 0;
+  NearestObstacle nearest[maxSectors];
+
+  xSemaphoreTake(lock, portMAX_DELAY);
+  for(size_t sampleNum=0; sampleNum<lenght; sampleNum++){
+    advanceSweep(anglesInQ6Degree[sampleNum]);
+    size_t sector = getSector(anglesInQ6Degree[sampleNum]);
+    uint16_t range = rangesInQuarterMillimeter[sampleNum];
+    if(range == 0){
+      continue;
+    }
+    NearestObstacle &running = current[sector];
+    if(running.rangeInQuarterMillimeter == 0 || range < running.rangeInQuarterMillimeter){
+      running.rangeInQuarterMillimeter = range;
+      running.angleInQ6Degree = anglesInQ6Degree[sampleNum];
+    }
+    revolutionsSinceUpdate[sector] = 0;
+  }
+
+  if(thresholdInQuarterMillimeter > 0){
+    for(size_t sector=0; sector<sectorCount; sector++){
+      nearest[sector] = nearestInSector(sector);
+      uint16_t range = nearest[sector].rangeInQuarterMillimeter;
+      uint32_t sectorBit = (uint32_t)1 << sector;
+      bool wasTooClose = (tooCloseSectors & sectorBit) != 0;
+      if(!wasTooClose && range != 0 && range < thresholdInQuarterMillimeter){
+        tooCloseSectors |= sectorBit;
+        changedSectors |= sectorBit;
+      }else if(wasTooClose && (range == 0 || range >= (uint32_t)thresholdInQuarterMillimeter + hysteresisInQuarterMillimeter)){
+        tooCloseSectors &= ~sectorBit;
+        changedSectors |= sectorBit;
+      }
+    }
+  }
+  uint32_t tooClose = tooCloseSectors;
+  xSemaphoreGive(lock);
+
+  // outside of the lock, so the handler may read the tracker
+  if(handler == nullptr){
+    return;
+  }
+  for(size_t sector=0; changedSectors != 0; sector++, changedSectors >>= 1){
+    if(changedSectors & 1){
+      handler->operator()(sector, (tooClose >> sector) & 1, nearest[sector]);
+    }
+  }
+}
+
+// the sweep only moves forward, small steps back are the jitter of the corrected angles.
+// every sector end passed on the way replaces the previous minimum of that sector
+void NearestObstacleTracker::advanceSweep(int32_t angleInQ6Degree){
+  if(!hasSweep){
+    int32_t behindMargin = angleInQ6Degree - sweepMarginInQ6Degree;
+    nextSectorToFinish = getSector(behindMargin < 0 ? behindMargin + fullCircleInQ6Degree : behindMargin);
+    sweepAngleInQ6Degree = angleInQ6Degree;
+    hasSweep = true;
+    return;
+  }
+  int32_t step = angleInQ6Degree - sweepAngleInQ6Degree;
+  if(step < 0){
+    step += fullCircleInQ6Degree;
+  }
+  if(step == 0 || step > fullCircleInQ6Degree - maxStepBackInQ6Degree){
+    return;
+  }
+  for(size_t finished=0; finished<sectorCount; finished++){
+    int32_t distanceToFinish = finishAngleInQ6Degree(nextSectorToFinish) - sweepAngleInQ6Degree;
+    if(distanceToFinish < 0){
+      distanceToFinish += fullCircleInQ6Degree;
+    }
+    if(distanceToFinish > step){
+      break;
+    }
+    if(current[nextSectorToFinish].rangeInQuarterMillimeter == 0 && revolutionsSinceUpdate[nextSectorToFinish] < UINT8_MAX){
+      revolutionsSinceUpdate[nextSectorToFinish]++;
+    }
+    previous[nextSectorToFinish] = current[nextSectorToFinish];
+    current[nextSectorToFinish].rangeInQuarterMillimeter = 0;
+    nextSectorToFinish = nextSectorToFinish+1 < sectorCount ? nextSectorToFinish+1 : 0;
+  }
+  sweepAngleInQ6Degree = angleInQ6Degree;
+}
+
+int32_t NearestObstacleTracker::finishAngleInQ6Degree(size_t sector){
+  int32_t angle = (int32_t)((2*sector+1) * fullCircleInQ6Degree / (2*sectorCount)) + sweepMarginInQ6Degree;
+  return angle < fullCircleInQ6Degree ? angle : angle - fullCircleInQ6Degree;
+}
+
+NearestObstacle NearestObstacleTracker::nearestInSector(size_t sector){
+  NearestObstacle nearest = current[sector];
+  if(previous[sector].rangeInQuarterMillimeter != 0 && (nearest.rangeInQuarterMillimeter == 0 || previous[sector].rangeInQuarterMillimeter < nearest.rangeInQuarterMillimeter)){
+    nearest = previous[sector];
+  }
+  // the sweep passed the sector without a valid sample
+  if(revolutionsSinceUpdate[sector] >= 1){
+    nearest.rangeInQuarterMillimeter = 0;
+  }
+  return nearest;
+}
+
+// drops all values without calling the handler
+void NearestObstacleTracker::clear(){
+  xSemaphoreTake(lock, portMAX_DELAY);
+  for(size_t sector=0; sector<maxSectors; sector++){
+    current[sector] = {0, 0};
+    previous[sector] = {0, 0};
+    revolutionsSinceUpdate[sector] = 0;
+  }
+  tooCloseSectors = 0;
+  hasSweep = false;
+  sweepAngleInQ6Degree = 0;
+  nextSectorToFinish = 0;
+  xSemaphoreGive(lock);
+}
+
+NearestObstacle NearestObstacleTracker::getNearest(size_t sector){
+  NearestObstacle nearest = {0, 0};
+  xSemaphoreTake(lock, portMAX_DELAY);
+  if(sector < sectorCount){
+    nearest = nearestInSector(sector);
+  }
+  xSemaphoreGive(lock);
+  return nearest;
+}
+
+void NearestObstacleTracker::copyTo(NearestObstacle nearest[]){
+  xSemaphoreTake(lock, portMAX_DELAY);
+  for(size_t sector=0; sector<sectorCount; sector++){
+    nearest[sector] = nearestInSector(sector);
+  }
+  xSemaphoreGive(lock);
+}
+
+bool NearestObstacleTracker::isTooClose(size_t sector){
+  xSemaphoreTake(lock, portMAX_DELAY);
+  bool isSectorTooClose = sector < sectorCount && (tooCloseSectors >> sector) & 1;
+  xSemaphoreGive(lock);
+  return isSectorTooClose;
+}
+
+size_t NearestObstacleTracker::getSectorCount(){
+  return sectorCount;
+}
+
+} // end namespace
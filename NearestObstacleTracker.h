@@ -0,0 +1,94 @@
+#ifndef __NEAREST_OBSTACLE_TRACKER__
+#define __NEAREST_OBSTACLE_TRACKER__
+
+#include <Arduino.h>
+#include <functional>
+
+namespace sensorYDLidarX4 {
+
+struct NearestObstacle{
+  uint16_t rangeInQuarterMillimeter; // 0: no valid sample in the last revolution
+  uint16_t angleInQ6Degree;
+};
+
+// called from update() (the task running the state machine) as soon as a sector crosses the threshold
+typedef std::function<void(size_t sector, bool isTooClose, const NearestObstacle &nearest)> OnNearestObstacleHandler;
+
+/*
+nearest obstacle per sector, updated with every decoded paket
+
+the circle is split into sectorCount sectors, sector 0 is centered on 0 degree.
+each sector keeps the minimum of the running sweep and of the previous one. when
+the sweep has passed the end of a sector (plus a margin for the angle correction,
+which lets the corrected angles jitter), its previous minimum expires, so a value
+is never older than about one revolution. a sector the sweep passed without a
+valid sample (e.g. skipped by the angular ROI) expires as well.
+
+the threshold is checked after every paket: the handler is called once when the
+nearest range of a sector drops below the threshold and once when it is above
+threshold + hysteresis again (or expired).
+
+  static NearestObstacleTracker tracker(8);
+  static OnNearestObstacleHandler onObstacle = [](size_t sector, bool isTooClose, const NearestObstacle &nearest){ ... };
+  tracker.setThreshold(300);
+  tracker.setHandler(onObstacle);
+  YDLidarX4::builder().setNearestObstacleTracker(tracker)...
+*/
+
+class NearestObstacleTracker{
+  public:
+    const static size_t maxSectors = 32;
+
+  private:
+    const static int32_t fullCircleInQ6Degree = 360*64;
+    // the correction moves neighbouring samples up to about 10 degree against each other
+    const static int32_t sweepMarginInQ6Degree = 10*64;
+    const static int32_t maxStepBackInQ6Degree = 20*64;
+
+    size_t sectorCount;
+    NearestObstacle current[maxSectors];
+    NearestObstacle previous[maxSectors];
+    uint8_t revolutionsSinceUpdate[maxSectors];
+    uint32_t tooCloseSectors;
+    bool hasSweep;
+    int32_t sweepAngleInQ6Degree;
+    size_t nextSectorToFinish;
+    uint16_t thresholdInQuarterMillimeter;
+    uint16_t hysteresisInQuarterMillimeter;
+    OnNearestObstacleHandler *handler;
+    SemaphoreHandle_t lock;
+
+    NearestObstacle nearestInSector(size_t sector);
+    void advanceSweep(int32_t angleInQ6Degree);
+    int32_t finishAngleInQ6Degree(size_t sector);
+
+  public:
+    NearestObstacleTracker(size_t sectorCount);
+    ~NearestObstacleTracker();
+    NearestObstacleTracker(const NearestObstacleTracker&) = delete;
+    NearestObstacleTracker& operator=(const NearestObstacleTracker&) = delete;
+
+    void setThreshold(float thresholdInMillimeter, float hysteresisInMillimeter = 50);
+    void setHandler(OnNearestObstacleHandler &handler);
+
+    void update(const uint16_t anglesInQ6Degree[], const uint16_t rangesInQuarterMillimeter[], size_t lenght);
+    void clear();
+
+    NearestObstacle getNearest(size_t sector);
+    // needs sectorCount elements
+    void copyTo(NearestObstacle nearest[]);
+    bool isTooClose(size_t sector);
+
+    size_t getSectorCount();
+    size_t getSector(uint16_t angleInQ6Degree);
+};
+
+inline size_t NearestObstacleTracker::getSector(uint16_t angleInQ6Degree){
+  const uint32_t fullCircleInQ6Degree = 360*64;
+  size_t sector = ((uint32_t)angleInQ6Degree * sectorCount + fullCircleInQ6Degree/2) / fullCircleInQ6Degree;
+  return sector < sectorCount ? sector : sector - sectorCount;
+}
+
+} // end namespace
+
+#endif
@@ -0,0 +1,182 @@
+#include <OccupancyGrid.h>
+#include <CartesianConverter.h>
+#include <cmath>
+#include <cstring>
+
+using std::memmove;
+using std::memset;
+
+namespace sensorYDLidarX4 {
+
+OccupancyGrid::OccupancyGrid(uint16_t width, uint16_t height, uint16_t cellSizeInMillimeter)
+  : width(width),
+  height(height),
+  cellSizeInMillimeter(cellSizeInMillimeter > 0 ? cellSizeInMillimeter : 1),
+  hitLogOdds(20),
+  missLogOdds(4),
+  minLogOdds(-100),
+  maxLogOdds(100),
+  maxRangeInQuarterMillimeter(10000*4),
+  poseXInMillimeter(0),
+  poseYInMillimeter(0),
+  headingInQ6Degree(0),
+  cellUpdateCount(0)
+{
+  cells = new int8_t[width * height];
+  // builds the shared sine table
+  CartesianConverter cartesianConverter;
+  clear();
+}
+
+OccupancyGrid::~OccupancyGrid(){
+  delete[] cells;
+}
+
+void OccupancyGrid::setLogOdds(int8_t hitLogOdds, int8_t missLogOdds, int8_t minLogOdds, int8_t maxLogOdds){
+  this->hitLogOdds = hitLogOdds;
+  this->missLogOdds = missLogOdds;
+  this->minLogOdds = minLogOdds;
+  this->maxLogOdds = maxLogOdds;
+}
+
+void OccupancyGrid::setMaxRange(float maxRangeInMillimeter){
+  maxRangeInQuarterMillimeter = lround(maxRangeInMillimeter * 4);
+}
+
+void OccupancyGrid::setPose(int32_t xInMillimeter, int32_t yInMillimeter, float headingInDegree){
+  poseXInMillimeter = xInMillimeter;
+  poseYInMillimeter = yInMillimeter;
+  int32_t heading = lround(headingInDegree * 64) % fullCircleInQ6Degree;
+  headingInQ6Degree = heading < 0 ? heading + fullCircleInQ6Degree : heading;
+}
+
+void OccupancyGrid::shift(int32_t cellsX, int32_t cellsY){
+  if(cellsX <= -width || cellsX >= width || cellsY <= -height || cellsY >= height){
+    clear();
+  }else if(cellsX != 0 || cellsY != 0){
+    // the cell (x, y) gets the content of (x + cellsX, y + cellsY)
+    int32_t firstRow = cellsY > 0 ? 0 : -cellsY;
+    int32_t lastRow = cellsY > 0 ? height - cellsY : height;
+    int32_t rowStep = cellsY > 0 ? 1 : -1;
+    int32_t copiedWidth = width - (cellsX > 0 ? cellsX : -cellsX);
+    int32_t targetColumn = cellsX > 0 ? 0 : -cellsX;
+    int32_t sourceColumn = cellsX > 0 ? cellsX : 0;
+    int32_t clearedColumn = cellsX > 0 ? copiedWidth : 0;
+    int32_t clearedWidth = width - copiedWidth;
+    // rows are copied in the direction which never overwrites a source row before it is read
+    for(int32_t row = rowStep > 0 ? firstRow : lastRow-1; row >= firstRow && row < lastRow; row += rowStep){
+      int8_t *target = &cells[row * width];
+      memmove(&target[targetColumn], &cells[(row + cellsY) * width + sourceColumn], copiedWidth);
+      memset(&target[clearedColumn], 0, clearedWidth);
+    }
+    int32_t clearedRows = cellsY > 0 ? cellsY : -cellsY;
+    memset(&cells[(cellsY > 0 ? height - cellsY : 0) * width], 0, clearedRows * width);
+  }
+  poseXInMillimeter -= cellsX * cellSizeInMillimeter;
+  poseYInMillimeter -= cellsY * cellSizeInMillimeter;
+}
+
+void OccupancyGrid::update(const uint16_t anglesInQ6Degree[], const uint16_t rangesInQuarterMillimeter[], size_t lenght){
+  int32_t fromX = toCell(poseXInMillimeter);
+  int32_t fromY = toCell(poseYInMillimeter);
+  if(fromX < 0 || fromX >= width || fromY < 0 || fromY >= height){
+    return;
+  }
+  for(size_t sampleNum=0; sampleNum<lenght; sampleNum++){
+    int32_t range = rangesInQuarterMillimeter[sampleNum];
+    if(range == 0){
+      continue;
+    }
+    bool isHit = range <= maxRangeInQuarterMillimeter;
+    if(!isHit){
+      range = maxRangeInQuarterMillimeter;
+    }
+    uint16_t angle = anglesInQ6Degree[sampleNum] + headingInQ6Degree;
+    angle = angle < fullCircleInQ6Degree ? angle : angle - fullCircleInQ6Degree;
+    // 0.25mm * 1/16384 -> mm
+    int32_t x = poseXInMillimeter + ((range * CartesianConverter::cosine(angle) + (1 << 15)) >> 16);
+    int32_t y = poseYInMillimeter + ((range * CartesianConverter::sine(angle) + (1 << 15)) >> 16);
+    traceRay(fromX, fromY, toCell(x), toCell(y), isHit);
+  }
+}
+
+// bresenham from the lidar cell (inside the grid) to the end cell, stops at the border
+void OccupancyGrid::traceRay(int32_t fromX, int32_t fromY, int32_t toX, int32_t toY, bool isHit){
+  int32_t dx = toX > fromX ? toX - fromX : fromX - toX;
+  int32_t dy = toY > fromY ? toY - fromY : fromY - toY;
+  int32_t stepX = toX > fromX ? 1 : -1;
+  int32_t stepY = toY > fromY ? width : -width;
+  int32_t x = fromX;
+  int32_t y = fromY;
+  int32_t columnStep = toX > fromX ? 1 : -1;
+  int32_t rowStep = toY > fromY ? 1 : -1;
+  int8_t *cell = &cells[fromY * width + fromX];
+  int32_t error = dx - dy;
+  int32_t cellCount = dx > dy ? dx : dy;
+
+  for(int32_t cellNum=0; cellNum<cellCount; cellNum++){
+    miss(*cell);
+    int32_t doubleError = 2 * error;
+    if(doubleError > -dy){
+      error -= dy;
+      x += columnStep;
+      cell += stepX;
+    }
+    if(doubleError < dx){
+      error += dx;
+      y += rowStep;
+      cell += stepY;
+    }
+    if(x < 0 || x >= width || y < 0 || y >= height){
+      cellUpdateCount += cellNum + 1;
+      return;
+    }
+  }
+  if(isHit){
+    hit(*cell);
+  }else{
+    miss(*cell);
+  }
+  cellUpdateCount += cellCount + 1;
+}
+
+void OccupancyGrid::clear(){
+  memset(cells, 0, width * height);
+}
+
+int8_t OccupancyGrid::getLogOdds(int32_t x, int32_t y){
+  if(x < 0 || x >= width || y < 0 || y >= height){
+    return 0;
+  }
+  return cells[y * width + x];
+}
+
+const int8_t* OccupancyGrid::getCells(){
+  return cells;
+}
+
+uint16_t OccupancyGrid::getWidth(){
+  return width;
+}
+
+uint16_t OccupancyGrid::getHeight(){
+  return height;
+}
+
+uint16_t OccupancyGrid::getCellSizeInMillimeter(){
+  return cellSizeInMillimeter;
+}
+
+int32_t OccupancyGrid::getPoseXInMillimeter(){
+  return poseXInMillimeter;
+}
+
+int32_t OccupancyGrid::getPoseYInMillimeter(){
+  return poseYInMillimeter;
+}
+
+unsigned long OccupancyGrid::getCellUpdateCount(){
+  return cellUpdateCount;
+}
+
+} // end namespace
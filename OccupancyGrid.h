@@ -0,0 +1,100 @@
+#ifndef __OCCUPANCY_GRID__
+#define __OCCUPANCY_GRID__
+
+#include <cstdint>
+#include <cstddef>
+
+namespace sensorYDLidarX4 {
+
+/*
+log odds occupancy grid, updated with every decoded paket
+
+one int8_t per cell, row by row (width*height bytes, 200x200 cells are 40kB).
+every sample is traced from the cell of the lidar to the cell of its end point
+with bresenham in integer math: the cells on the way get the miss value, the end
+cell the hit value. both are clamped to [min, max]. samples beyond the max range
+only clear the cells up to the max range, samples without a range are skipped.
+
+the grid is a window into the world: cell (0, 0) is the lower left corner and the
+pose of the lidar is given in millimeter relative to it. shift() moves the window
+(e.g. to keep the robot in the center), the cells moved in are unknown (0).
+
+the grid is not synchronized: update() runs in the task of the state machine, so
+read it from there (e.g. in a packet handler) or after runBatch().
+
+  static OccupancyGrid grid(200, 200, 50);   // 10m x 10m in 5cm cells
+  grid.setPose(5000, 5000, 0);
+  YDLidarX4::builder().setOccupancyGrid(grid)...
+*/
+
+class OccupancyGrid{
+  private:
+    const static uint16_t fullCircleInQ6Degree = 360*64;
+
+    int32_t width;
+    int32_t height;
+    int32_t cellSizeInMillimeter;
+    int8_t *cells;
+
+    int8_t hitLogOdds;
+    int8_t missLogOdds;
+    int8_t minLogOdds;
+    int8_t maxLogOdds;
+    int32_t maxRangeInQuarterMillimeter;
+
+    int32_t poseXInMillimeter;
+    int32_t poseYInMillimeter;
+    uint16_t headingInQ6Degree;
+
+    unsigned long cellUpdateCount;
+
+    void traceRay(int32_t fromX, int32_t fromY, int32_t toX, int32_t toY, bool isHit);
+    void miss(int8_t &cell);
+    void hit(int8_t &cell);
+    int32_t toCell(int32_t millimeter);
+
+  public:
+    OccupancyGrid(uint16_t width, uint16_t height, uint16_t cellSizeInMillimeter);
+    ~OccupancyGrid();
+    OccupancyGrid(const OccupancyGrid&) = delete;
+    OccupancyGrid& operator=(const OccupancyGrid&) = delete;
+
+    void setLogOdds(int8_t hitLogOdds, int8_t missLogOdds, int8_t minLogOdds = -100, int8_t maxLogOdds = 100);
+    void setMaxRange(float maxRangeInMillimeter);
+    // lidar position relative to the lower left corner of the grid, heading counter clockwise
+    void setPose(int32_t xInMillimeter, int32_t yInMillimeter, float headingInDegree);
+    // moves the window by whole cells in the world, the pose moves the other way
+    void shift(int32_t cellsX, int32_t cellsY);
+
+    void update(const uint16_t anglesInQ6Degree[], const uint16_t rangesInQuarterMillimeter[], size_t lenght);
+    void clear();
+
+    // 0: unknown, > 0: occupied, < 0: free
+    int8_t getLogOdds(int32_t x, int32_t y);
+    const int8_t* getCells();
+    uint16_t getWidth();
+    uint16_t getHeight();
+    uint16_t getCellSizeInMillimeter();
+    int32_t getPoseXInMillimeter();
+    int32_t getPoseYInMillimeter();
+    unsigned long getCellUpdateCount();
+};
+
+inline void OccupancyGrid::miss(int8_t &cell){
+  int32_t value = cell - missLogOdds;
+  cell = value < minLogOdds ? minLogOdds : value;
+}
+
+inline void OccupancyGrid::hit(int8_t &cell){
+  int32_t value = cell + hitLogOdds;
+  cell = value > maxLogOdds ? maxLogOdds : value;
+}
+
+// floor division, so the cells left of / below the grid are negative
+inline int32_t OccupancyGrid::toCell(int32_t millimeter){
+  return millimeter >= 0 ? millimeter / cellSizeInMillimeter : -((cellSizeInMillimeter - 1 - millimeter) / cellSizeInMillimeter);
+}
+
+} // end namespace
+
+#endif
@@ -0,0 +1,66 @@
+#include <PolarGrid.h>
+#include <cstring>
+
+using std::memcpy;
+using std::memset;
+
+namespace sensorYDLidarX4 {
+
+PolarGrid::PolarGrid(size_t binCount)
+  : binCount(binCount),
+  lock(xSemaphoreCreateMutex())
+{
+  rangesInQuarterMillimeter = new uint16_t[binCount];
+  revolutions = new uint16_t[binCount];
+  clear();
+}
+
+PolarGrid::~PolarGrid(){
+  vSemaphoreDelete(lock);
+  delete[] rangesInQuarterMillimeter;
+  delete[] revolutions;
+}
+
+void PolarGrid::update(const uint16_t anglesInQ6Degree[], const uint16_t rangesInQuarterMillimeter[], size_t lenght, uint16_t revolution){
+  xSemaphoreTake(lock, portMAX_DELAY);
+  for(size_t sampleNum=0; sampleNum<lenght; sampleNum++){
+    size_t bin = getBin(anglesInQ6Degree[sampleNum]);
+    this->rangesInQuarterMillimeter[bin] = rangesInQuarterMillimeter[sampleNum];
+    this->revolutions[bin] = revolution;
+  }
+  xSemaphoreGive(lock);
+}
+
+void PolarGrid::clear(){
+  xSemaphoreTake(lock, portMAX_DELAY);
+  memset(rangesInQuarterMillimeter, 0, binCount * sizeof(uint16_t));
+  memset(revolutions, 0, binCount * sizeof(uint16_t));
+  xSemaphoreGive(lock);
+}
+
+void PolarGrid::copyTo(uint16_t rangesInQuarterMillimeter[], uint16_t revolutions[]){
+  xSemaphoreTake(lock, portMAX_DELAY);
+  memcpy(rangesInQuarterMillimeter, this->rangesInQuarterMillimeter, binCount * sizeof(uint16_t));
+  if(revolutions != nullptr){
+    memcpy(revolutions, this->revolutions, binCount * sizeof(uint16_t));
+  }
+  xSemaphoreGive(lock);
+}
+
+size_t PolarGrid::getBinCount(){
+  return binCount;
+}
+
+float PolarGrid::getBinAngleInDegree(size_t bin){
+  return bin * 360.0f / binCount;
+}
+
+float PolarGrid::getRangeInMillimeter(size_t bin){
+  return rangesInQuarterMillimeter[bin] / 4.0f;
+}
+
+uint16_t PolarGrid::getRevolution(size_t bin){
+  return revolutions[bin];
+}
+
+} // end namespace
@@ -0,0 +1,55 @@
+#ifndef __POLAR_GRID__
+#define __POLAR_GRID__
+
+#include <Arduino.h>
+
+namespace sensorYDLidarX4 {
+
+/*
+latest range per bearing
+
+the circle is split into binCount bins (720 = 0.5 degree, 360 = 1 degree),
+bin 0 is centered on 0 degree. every decoded sample overwrites its bin in O(1)
+together with the revolution it was measured in. the grid is updated once per
+paket under a mutex, so copyTo() always returns a consistent state.
+
+  static PolarGrid polarGrid(720);
+  YDLidarX4::builder().setPolarGrid(polarGrid)...
+  ...
+  polarGrid.copyTo(rangesInQuarterMillimeter, revolutions);
+*/
+
+class PolarGrid{
+  private:
+    size_t binCount;
+    uint16_t *rangesInQuarterMillimeter;
+    uint16_t *revolutions;
+    SemaphoreHandle_t lock;
+
+  public:
+    PolarGrid(size_t binCount);
+    ~PolarGrid();
+    PolarGrid(const PolarGrid&) = delete;
+    PolarGrid& operator=(const PolarGrid&) = delete;
+
+    void update(const uint16_t anglesInQ6Degree[], const uint16_t rangesInQuarterMillimeter[], size_t lenght, uint16_t revolution);
+    void clear();
+    // both arrays need binCount elements, revolutions may be nullptr
+    void copyTo(uint16_t rangesInQuarterMillimeter[], uint16_t revolutions[]);
+
+    size_t getBinCount();
+    size_t getBin(uint16_t angleInQ6Degree);
+    float getBinAngleInDegree(size_t bin);
+    float getRangeInMillimeter(size_t bin);
+    uint16_t getRevolution(size_t bin);
+};
+
+inline size_t PolarGrid::getBin(uint16_t angleInQ6Degree){
+  const uint32_t fullCircleInQ6Degree = 360*64;
+  size_t bin = ((uint32_t)angleInQ6Degree * binCount + fullCircleInQ6Degree/2) / fullCircleInQ6Degree;
+  return bin < binCount ? bin : bin - binCount;
+}
+
+} // end namespace
+
+#endif
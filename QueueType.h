@@ -0,0 +1,13 @@
+#ifndef __QUEUE_TYPE__
+#define __QUEUE_TYPE__
+
+namespace sensorYDLidarX4{
+
+enum QueueType{
+  QUEUE_SYNCHRONIZED,  // FreeRTOS mutex per access
+  QUEUE_LOCK_FREE      // single producer/single consumer ring with atomics
+};
+
+} // end namespace
+
+#endif
@@ -0,0 +1,160 @@
+#include <RangeFilter.h>
+#include <cstring>
+
+using std::memmove;
+
+namespace sensorYDLidarX4 {
+
+const float RangeFilter::maxGapInDegree = 2;
+
+RangeFilter::RangeFilter()
+  : medianWindow(1),
+  spikeThresholdInMillimeter(0),
+  minRangeInMillimeter(0),
+  maxRangeInMillimeter(16384),
+  historySize(0),
+  lastAngleInDegree(0),
+  rejectedSampleCount(0)
+{
+}
+
+void RangeFilter::setMedianWindow(size_t medianWindow){
+  medianWindow |= 1;
+  this->medianWindow = medianWindow < maxMedianWindow ? medianWindow : maxMedianWindow;
+}
+
+void RangeFilter::setSpikeThreshold(float spikeThresholdInMillimeter){
+  this->spikeThresholdInMillimeter = spikeThresholdInMillimeter;
+}
+
+void RangeFilter::setRangeGate(float minRangeInMillimeter, float maxRangeInMillimeter){
+  this->minRangeInMillimeter = minRangeInMillimeter;
+  this->maxRangeInMillimeter = maxRangeInMillimeter;
+}
+
+void RangeFilter::reset(){
+  historySize = 0;
+  rejectedSampleCount = 0;
+}
+
+unsigned long RangeFilter::getRejectedSampleCount(){
+  return rejectedSampleCount;
+}
+
+bool RangeFilter::filter(const float anglesInDegree[], float rangesInMillimeter[], size_t lenght){
+  if(lenght > maxSamplesPerPaket){
+    return false;
+  }
+  if(lenght == 0){
+    return true;
+  }
+  if(!isContinuation(anglesInDegree[0])){
+    historySize = 0;
+  }
+  lastAngleInDegree = anglesInDegree[lenght-1];
+
+  float *current = &samples[maxHistory];
+  gate(rangesInMillimeter, current, lenght);
+  if(spikeThresholdInMillimeter > 0){
+    rejectSpikes(current, lenght);
+  }
+
+  // the median reads the gated samples and writes the output
+  size_t halfWindow = medianWindow/2;
+  for(size_t sampleNum=0; sampleNum<lenght; sampleNum++){
+    if(current[sampleNum] == 0 || halfWindow == 0){
+      rangesInMillimeter[sampleNum] = current[sampleNum];
+      continue;
+    }
+    size_t before = sampleNum + historySize < halfWindow ? sampleNum + historySize : halfWindow;
+    size_t after = lenght - 1 - sampleNum < halfWindow ? lenght - 1 - sampleNum : halfWindow;
+    rangesInMillimeter[sampleNum] = median(&current[sampleNum] - before, before + 1 + after);
+  }
+
+  keepHistory(lenght);
+  return true;
+}
+
+bool RangeFilter::isContinuation(float firstAngleInDegree){
+  if(historySize == 0){
+    return false;
+  }
+  float gap = firstAngleInDegree - lastAngleInDegree;
+  if(gap < -180){
+    gap += 360;
+  }else if(gap > 180){
+    gap -= 360;
+  }
+  return gap > -maxGapInDegree && gap < maxGapInDegree;
+}
+
+void RangeFilter::gate(const float rangesInMillimeter[], float *current, size_t lenght){
+  for(size_t sampleNum=0; sampleNum<lenght; sampleNum++){
+    float range = rangesInMillimeter[sampleNum];
+    if(range != 0 && (range < minRangeInMillimeter || range > maxRangeInMillimeter)){
+      range = 0;
+      rejectedSampleCount++;
+    }
+    current[sampleNum] = range;
+  }
+}
+
+bool RangeFilter::isSpike(float left, float range, float right){
+  if(range == 0 || left == 0 || right == 0){
+    return false;
+  }
+  float toLeft = range - left;
+  float toRight = range - right;
+  float neighbours = left - right;
+  return (toLeft > spikeThresholdInMillimeter || toLeft < -spikeThresholdInMillimeter)
+    && (toRight > spikeThresholdInMillimeter || toRight < -spikeThresholdInMillimeter)
+    && neighbours <= spikeThresholdInMillimeter && neighbours >= -spikeThresholdInMillimeter;
+}
+
+// the last sample has no right neighbour yet and is passed on unchecked.
+// it is checked with the next paket, but as it is already out, a spike is only
+// removed from the history so it does not reach the median of the next paket
+void RangeFilter::rejectSpikes(float *current, size_t lenght){
+  float left = historySize > 0 ? current[-1] : 0;
+  if(historySize > 1 && isSpike(current[-2], left, current[0])){
+    current[-1] = 0;
+  }
+  for(size_t sampleNum=0; sampleNum+1<lenght; sampleNum++){
+    float range = current[sampleNum];
+    if(isSpike(left, range, current[sampleNum+1])){
+      current[sampleNum] = 0;
+      rejectedSampleCount++;
+    }
+    // the unfiltered value is the left neighbour of the next sample
+    left = range;
+  }
+}
+
+// median of the non zero values, the window has at most maxMedianWindow values
+float RangeFilter::median(const float *window, size_t size){
+  float sorted[maxMedianWindow];
+  size_t count = 0;
+  for(size_t index=0; index<size; index++){
+    float value = window[index];
+    if(value == 0){
+      continue;
+    }
+    size_t position = count++;
+    while(position > 0 && sorted[position-1] > value){
+      sorted[position] = sorted[position-1];
+      position--;
+    }
+    sorted[position] = value;
+  }
+  return sorted[count/2];
+}
+
+// the last samples (before the median) are moved in front of the next paket
+void RangeFilter::keepHistory(size_t lenght){
+  size_t available = historySize + lenght;
+  size_t newHistorySize = available < maxHistory ? available : maxHistory;
+  memmove(&samples[maxHistory - newHistorySize], &samples[maxHistory + lenght - newHistorySize], newHistorySize * sizeof(float));
+  historySize = newHistorySize;
+}
+
+} // end namespace
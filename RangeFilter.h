@@ -0,0 +1,79 @@
+#ifndef __RANGE_FILTER__
+#define __RANGE_FILTER__
+
+#include <cstddef>
+
+namespace sensorYDLidarX4 {
+
+/*
+filter stage for the float ranges of the pakets
+
+it only runs on the float path (packet handlers, timed packet handler, frames and
+clusters).
+the fixed point path - fixed point handler and callback, PolarGrid,
+NearestObstacleTracker, OccupancyGrid and the point clouds - gets unfiltered ranges.
+
+1. range gate: ranges outside [min, max] become 0
+2. spike rejection: a sample which differs by more than the threshold from both
+   neighbours, while the neighbours agree, becomes 0
+3. sliding median over the valid (non zero) samples of the window, a sample
+   without range stays 0
+
+the last samples of a paket are kept as history, so the filter continues across
+paket boundaries as long as the next paket starts next to the last one. at the end
+of a paket the window only covers the samples received so far. the last sample
+of a paket has no right neighbour yet, so it is not spike filtered (a spike there
+is only kept out of the median of the next paket). nothing is allocated while
+filtering.
+
+  static RangeFilter rangeFilter;
+  rangeFilter.setMedianWindow(5);
+  rangeFilter.setSpikeThreshold(150);
+  rangeFilter.setRangeGate(120, 10000);
+  YDLidarX4::builder().setRangeFilter(rangeFilter)...
+*/
+
+class RangeFilter{
+  public:
+    const static size_t maxMedianWindow = 9;
+
+  private:
+    const static size_t maxHistory = maxMedianWindow/2;
+    const static size_t maxSamplesPerPaket = 255;
+    const static float maxGapInDegree;
+
+    size_t medianWindow;
+    float spikeThresholdInMillimeter;
+    float minRangeInMillimeter;
+    float maxRangeInMillimeter;
+
+    // history followed by the samples of the current paket
+    float samples[maxHistory + maxSamplesPerPaket];
+    size_t historySize;
+    float lastAngleInDegree;
+    unsigned long rejectedSampleCount;
+
+    bool isContinuation(float firstAngleInDegree);
+    void gate(const float rangesInMillimeter[], float *current, size_t lenght);
+    bool isSpike(float left, float range, float right);
+    void rejectSpikes(float *current, size_t lenght);
+    float median(const float *window, size_t size);
+    void keepHistory(size_t lenght);
+
+  public:
+    RangeFilter();
+    // 1 disables the median, even sizes are rounded up
+    void setMedianWindow(size_t medianWindow);
+    // 0 disables the spike rejection
+    void setSpikeThreshold(float spikeThresholdInMillimeter);
+    void setRangeGate(float minRangeInMillimeter, float maxRangeInMillimeter);
+    void reset();
+
+    // returns false (and leaves the ranges unfiltered) for more than 255 samples
+    bool filter(const float anglesInDegree[], float rangesInMillimeter[], size_t lenght);
+    unsigned long getRejectedSampleCount();
+};
+
+} // end namespace
+
+#endif
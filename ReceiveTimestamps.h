@@ -0,0 +1,91 @@
+#ifndef __RECEIVE_TIMESTAMPS__
+#define __RECEIVE_TIMESTAMPS__
+
+#include <atomic>
+#include <cstdint>
+#include <LockFreeQueue.h>
+
+namespace sensorYDLidarX4 {
+
+struct ReceiveTimestamp{
+  uint32_t endPosition;         // stream position behind the last byte of the batch
+  unsigned long timeInMicros;
+};
+
+/*
+receive time of the bytes in the lidar queue
+
+the receiver (producer) adds one timestamp per received batch, the state
+machine (consumer) reports every byte it removes from the queue. so the
+receive time of any byte in the queue can be looked up by its offset from
+the queue head. it uses the same single producer / single consumer scheme
+as LockFreeQueue. every stored batch keeps at least one unconsumed byte in
+the lidar queue, so a capacity of the lidar queue capacity never overflows.
+if it does anyway (consumer out of sync), add returns false and the bytes
+of the dropped batch get the fallback time of getTimeInMicros.
+
+producer side: add
+consumer side: consume, clear, getTimeInMicros
+*/
+
+class ReceiveTimestamps{
+  private:
+    LockFreeQueue<ReceiveTimestamp> timestamps;
+    std::atomic<uint32_t> receivedPosition;
+    uint32_t consumedPosition;
+
+  public:
+    ReceiveTimestamps(size_t capacity);
+    bool add(size_t size, unsigned long timeInMicros);
+    void consume(size_t size);
+    void clear();
+    // receive time of the byte at offset behind the queue head, fallback if unknown
+    unsigned long getTimeInMicros(size_t offset, unsigned long fallbackTimeInMicros);
+};
+
+inline ReceiveTimestamps::ReceiveTimestamps(size_t capacity)
+  : timestamps(capacity),
+  receivedPosition(0),
+  consumedPosition(0)
+{
+}
+
+// returns false if the batch could not be stored
+inline bool ReceiveTimestamps::add(size_t size, unsigned long timeInMicros){
+  if(size == 0){
+    return true;
+  }
+  uint32_t endPosition = receivedPosition.load(std::memory_order_relaxed) + size;
+  bool added = timestamps.add({endPosition, timeInMicros});
+  receivedPosition.store(endPosition, std::memory_order_release);
+  return added;
+}
+
+inline void ReceiveTimestamps::consume(size_t size){
+  consumedPosition += size;
+  // drop the batches which are completely consumed, the positions may wrap around
+  while(!timestamps.isEmpty() && (int32_t)(timestamps.get(0).endPosition - consumedPosition) <= 0){
+    timestamps.dequeue();
+  }
+}
+
+inline void ReceiveTimestamps::clear(){
+  consumedPosition = receivedPosition.load(std::memory_order_acquire);
+  timestamps.clear();
+}
+
+inline unsigned long ReceiveTimestamps::getTimeInMicros(size_t offset, unsigned long fallbackTimeInMicros){
+  uint32_t position = consumedPosition + offset;
+  size_t count = timestamps.size();
+  for(size_t index=0; index<count; index++){
+    ReceiveTimestamp timestamp = timestamps.get(index);
+    if((int32_t)(timestamp.endPosition - position) > 0){
+      return timestamp.timeInMicros;
+    }
+  }
+  return fallbackTimeInMicros;
+}
+
+} // end namespace
+
+#endif
@@ -0,0 +1,288 @@
+#include <ScanMatcher.h>
+#include <cmath>
+
+namespace sensorYDLidarX4 {
+
+ScanMatcher::ScanMatcher(size_t maxPoints, size_t gridSize)
+  : maxPoints(maxPoints < UINT16_MAX ? maxPoints : UINT16_MAX),
+  gridSize(gridSize > 0 ? gridSize : 1),
+  reference(&scans[0]),
+  current(&scans[1]),
+  maxIterations(10),
+  maxCorrespondenceDistanceInMillimeter(300),
+  neighbourDistanceInMillimeter(200),
+  minCorrespondences(20),
+  initialXInMillimeter(0),
+  initialYInMillimeter(0),
+  initialRotationInDegree(0)
+{
+  for(ScanPoints &scan : scans){
+    scan.xInMillimeter = new float[this->maxPoints];
+    scan.yInMillimeter = new float[this->maxPoints];
+    scan.normalX = new float[this->maxPoints];
+    scan.normalY = new float[this->maxPoints];
+    scan.size = 0;
+  }
+  cellStart = new uint16_t[this->gridSize * this->gridSize + 1];
+  sortedPoints = new uint16_t[this->maxPoints];
+}
+
+ScanMatcher::~ScanMatcher(){
+  for(ScanPoints &scan : scans){
+    delete[] scan.xInMillimeter;
+    delete[] scan.yInMillimeter;
+    delete[] scan.normalX;
+    delete[] scan.normalY;
+  }
+  delete[] cellStart;
+  delete[] sortedPoints;
+}
+
+void ScanMatcher::setMaxIterations(size_t maxIterations){
+  this->maxIterations = maxIterations;
+}
+
+// also the cell size of the grid, it should be above the motion between two revolutions
+void ScanMatcher::setMaxCorrespondenceDistance(float maxCorrespondenceDistanceInMillimeter){
+  this->maxCorrespondenceDistanceInMillimeter = maxCorrespondenceDistanceInMillimeter;
+}
+
+void ScanMatcher::setMinCorrespondences(size_t minCorrespondences){
+  this->minCorrespondences = minCorrespondences;
+}
+
+void ScanMatcher::setInitialGuess(float xInMillimeter, float yInMillimeter, float rotationInDegree){
+  initialXInMillimeter = xInMillimeter;
+  initialYInMillimeter = yInMillimeter;
+  initialRotationInDegree = rotationInDegree;
+}
+
+// the next scan becomes the reference without a match
+void ScanMatcher::reset(){
+  reference->size = 0;
+}
+
+bool ScanMatcher::match(const LidarFrame &frame, ScanMatchResult &result){
+  return match(frame.anglesInDegree, frame.rangesInMillimeter, frame.size, result);
+}
+
+bool ScanMatcher::match(const float anglesInDegree[], const float rangesInMillimeter[], size_t lenght, ScanMatchResult &result){
+  const float toRad = 3.14159265359f / 180;
+  result = {0, 0, 0, 0, 0, 0, false};
+  toPoints(anglesInDegree, rangesInMillimeter, lenght, *current);
+
+  if(reference->size > 0){
+    buildGrid(*reference);
+    float rotation = initialRotationInDegree * toRad;
+    float translationX = initialXInMillimeter;
+    float translationY = initialYInMillimeter;
+    float maxDistanceSquared = maxCorrespondenceDistanceInMillimeter * maxCorrespondenceDistanceInMillimeter;
+    bool isSolved = false;
+
+    for(size_t iteration=0; iteration<maxIterations; iteration++){
+      float cosine = cosf(rotation);
+      float sine = sinf(rotation);
+      float h[3][3] = {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
+      float b[3] = {0, 0, 0};
+      float errorSum = 0;
+      size_t correspondenceCount = 0;
+
+      for(size_t pointNum=0; pointNum<current->size; pointNum++){
+        float x = cosine * current->xInMillimeter[pointNum] - sine * current->yInMillimeter[pointNum] + translationX;
+        float y = sine * current->xInMillimeter[pointNum] + cosine * current->yInMillimeter[pointNum] + translationY;
+        size_t nearest;
+        if(!findNearest(x, y, nearest)){
+          continue;
+        }
+        float dx = x - reference->xInMillimeter[nearest];
+        float dy = y - reference->yInMillimeter[nearest];
+        if(dx*dx + dy*dy > maxDistanceSquared){
+          continue;
+        }
+        float normalX = reference->normalX[nearest];
+        float normalY = reference->normalY[nearest];
+        float residual = dx*normalX + dy*normalY;
+        // derivative of the residual by the increment (x, y, rotation around the origin)
+        float jacobian[3] = {normalX, normalY, normalY*x - normalX*y};
+        for(int row=0; row<3; row++){
+          for(int column=0; column<3; column++){
+            h[row][column] += jacobian[row] * jacobian[column];
+          }
+          b[row] -= jacobian[row] * residual;
+        }
+        errorSum += residual * residual;
+        correspondenceCount++;
+      }
+
+      result.correspondenceCount = correspondenceCount;
+      result.rmsErrorInMillimeter = correspondenceCount > 0 ? sqrtf(errorSum / correspondenceCount) : 0;
+      result.iterations = iteration+1;
+      float delta[3];
+      if(correspondenceCount < minCorrespondences || !solve(h, b, delta)){
+        break;
+      }
+      isSolved = true;
+      // the increment is applied after the current estimate
+      float deltaCosine = cosf(delta[2]);
+      float deltaSine = sinf(delta[2]);
+      float movedX = deltaCosine * translationX - deltaSine * translationY + delta[0];
+      translationY = deltaSine * translationX + deltaCosine * translationY + delta[1];
+      translationX = movedX;
+      rotation += delta[2];
+      if(fabsf(delta[0]) + fabsf(delta[1]) < 0.1f && fabsf(delta[2]) < 0.0001f){
+        break;
+      }
+    }
+
+    result.xInMillimeter = translationX;
+    result.yInMillimeter = translationY;
+    result.rotationInDegree = rotation / toRad;
+    // without a single solved step the result is only the initial guess
+    result.isValid = isSolved && result.correspondenceCount >= minCorrespondences;
+  }
+  // the guess is for one match only
+  setInitialGuess(0, 0, 0);
+
+  calculateNormals(*current);
+  ScanPoints *previous = reference;
+  reference = current;
+  current = previous;
+  return result.isValid;
+}
+
+void ScanMatcher::toPoints(const float anglesInDegree[], const float rangesInMillimeter[], size_t lenght, ScanPoints &scan){
+  const float toRad = 3.14159265359f / 180;
+  size_t pointCount = 0;
+  for(size_t sampleNum=0; sampleNum<lenght && pointCount<maxPoints; sampleNum++){
+    float range = rangesInMillimeter[sampleNum];
+    if(range <= 0){
+      continue;
+    }
+    float angle = anglesInDegree[sampleNum] * toRad;
+    scan.xInMillimeter[pointCount] = range * cosf(angle);
+    scan.yInMillimeter[pointCount] = range * sinf(angle);
+    pointCount++;
+  }
+  scan.size = pointCount;
+}
+
+// perpendicular to the line between the two neighbours, if both are close enough
+void ScanMatcher::calculateNormals(ScanPoints &scan){
+  float maxDistanceSquared = neighbourDistanceInMillimeter * neighbourDistanceInMillimeter;
+  for(size_t pointNum=0; pointNum<scan.size; pointNum++){
+    scan.normalX[pointNum] = 0;
+    scan.normalY[pointNum] = 0;
+    if(pointNum == 0 || pointNum+1 == scan.size){
+      continue;
+    }
+    float x = scan.xInMillimeter[pointNum];
+    float y = scan.yInMillimeter[pointNum];
+    float previousX = scan.xInMillimeter[pointNum-1] - x;
+    float previousY = scan.yInMillimeter[pointNum-1] - y;
+    float nextX = scan.xInMillimeter[pointNum+1] - x;
+    float nextY = scan.yInMillimeter[pointNum+1] - y;
+    if(previousX*previousX + previousY*previousY > maxDistanceSquared || nextX*nextX + nextY*nextY > maxDistanceSquared){
+      continue;
+    }
+    float directionX = nextX - previousX;
+    float directionY = nextY - previousY;
+    float length = sqrtf(directionX*directionX + directionY*directionY);
+    if(length > 0){
+      scan.normalX[pointNum] = -directionY / length;
+      scan.normalY[pointNum] = directionX / length;
+    }
+  }
+}
+
+int32_t ScanMatcher::cellCoordinate(float millimeter){
+  return (int32_t)floorf(millimeter / maxCorrespondenceDistanceInMillimeter);
+}
+
+// the grid repeats every gridSize cells, so it covers any extent (far points only share cells)
+size_t ScanMatcher::cellOf(float xInMillimeter, float yInMillimeter){
+  int32_t column = cellCoordinate(xInMillimeter) % (int32_t)gridSize;
+  int32_t row = cellCoordinate(yInMillimeter) % (int32_t)gridSize;
+  column = column < 0 ? column + gridSize : column;
+  row = row < 0 ? row + gridSize : row;
+  return row * gridSize + column;
+}
+
+// counting sort of the points with a normal by their cell
+void ScanMatcher::buildGrid(const ScanPoints &scan){
+  size_t cellCount = gridSize * gridSize;
+  for(size_t cell=0; cell<=cellCount; cell++){
+    cellStart[cell] = 0;
+  }
+  for(size_t pointNum=0; pointNum<scan.size; pointNum++){
+    if(scan.normalX[pointNum] != 0 || scan.normalY[pointNum] != 0){
+      cellStart[cellOf(scan.xInMillimeter[pointNum], scan.yInMillimeter[pointNum]) + 1]++;
+    }
+  }
+  for(size_t cell=0; cell<cellCount; cell++){
+    cellStart[cell+1] += cellStart[cell];
+  }
+  // cellStart[cell] is used as write position and ends up as the start of the next cell
+  for(size_t pointNum=0; pointNum<scan.size; pointNum++){
+    if(scan.normalX[pointNum] != 0 || scan.normalY[pointNum] != 0){
+      sortedPoints[cellStart[cellOf(scan.xInMillimeter[pointNum], scan.yInMillimeter[pointNum])]++] = pointNum;
+    }
+  }
+  for(size_t cell=cellCount; cell>0; cell--){
+    cellStart[cell] = cellStart[cell-1];
+  }
+  cellStart[0] = 0;
+}
+
+bool ScanMatcher::findNearest(float x, float y, size_t &nearest){
+  int32_t column = cellCoordinate(x);
+  int32_t row = cellCoordinate(y);
+  float minDistanceSquared = INFINITY;
+  for(int32_t rowOffset=-1; rowOffset<=1; rowOffset++){
+    for(int32_t columnOffset=-1; columnOffset<=1; columnOffset++){
+      int32_t wrappedColumn = (column + columnOffset) % (int32_t)gridSize;
+      int32_t wrappedRow = (row + rowOffset) % (int32_t)gridSize;
+      wrappedColumn = wrappedColumn < 0 ? wrappedColumn + gridSize : wrappedColumn;
+      wrappedRow = wrappedRow < 0 ? wrappedRow + gridSize : wrappedRow;
+      size_t cell = wrappedRow * gridSize + wrappedColumn;
+      for(size_t index=cellStart[cell]; index<cellStart[cell+1]; index++){
+        size_t pointNum = sortedPoints[index];
+        float dx = x - reference->xInMillimeter[pointNum];
+        float dy = y - reference->yInMillimeter[pointNum];
+        float distanceSquared = dx*dx + dy*dy;
+        if(distanceSquared < minDistanceSquared){
+          minDistanceSquared = distanceSquared;
+          nearest = pointNum;
+        }
+      }
+    }
+  }
+  return minDistanceSquared != INFINITY;
+}
+
+// cramer's rule on the 3x3 normal equations, false if they are (nearly) singular
+bool ScanMatcher::solve(const float h[3][3], const float b[3], float delta[3]){
+  float minor0 = h[1][1]*h[2][2] - h[1][2]*h[2][1];
+  float minor1 = h[1][0]*h[2][2] - h[1][2]*h[2][0];
+  float minor2 = h[1][0]*h[2][1] - h[1][1]*h[2][0];
+  float determinant = h[0][0]*minor0 - h[0][1]*minor1 + h[0][2]*minor2;
+  // the translation terms share one scale, so a single unseen direction (one straight wall) is singular
+  float translationScale = h[0][0] + h[1][1];
+  float scale = translationScale * translationScale * h[2][2];
+  if(!(fabsf(determinant) > 1e-6f * fabsf(scale)) || determinant == 0){
+    return false;
+  }
+  for(int unknown=0; unknown<3; unknown++){
+    float m[3][3];
+    for(int row=0; row<3; row++){
+      for(int column=0; column<3; column++){
+        m[row][column] = column == unknown ? b[row] : h[row][column];
+      }
+    }
+    delta[unknown] = (m[0][0]*(m[1][1]*m[2][2] - m[1][2]*m[2][1])
+      - m[0][1]*(m[1][0]*m[2][2] - m[1][2]*m[2][0])
+      + m[0][2]*(m[1][0]*m[2][1] - m[1][1]*m[2][0])) / determinant;
+  }
+  return true;
+}
+
+} // end namespace
@@ -0,0 +1,98 @@
+#ifndef __SCAN_MATCHER__
+#define __SCAN_MATCHER__
+
+#include <cstdint>
+#include <cstddef>
+#include <FrameAssembler.h>
+
+namespace sensorYDLidarX4 {
+
+// pose of the current scan in the frame of the previous one (the motion of the lidar in between)
+struct ScanMatchResult{
+  float xInMillimeter;
+  float yInMillimeter;
+  float rotationInDegree;
+  size_t correspondenceCount;
+  float rmsErrorInMillimeter;   // point to line distance of the correspondences
+  size_t iterations;
+  bool isValid;                 // false for the first scan or with too few correspondences
+};
+
+/*
+point to line ICP between two consecutive revolutions
+
+every match() takes the corrected angles and ranges of one revolution (e.g. a
+LidarFrame), matches them against the previous scan and keeps them as the next
+reference. the reference points are sorted into a hashed grid with the max
+correspondence distance as cell size, so the nearest neighbour is searched in
+3x3 cells only. the normal of a reference point comes from its neighbours in
+angle order, points without close neighbours get no normal and are skipped.
+
+each iteration is one gauss newton step on the point to line distances, the
+iteration count is fixed (it ends earlier if the step gets tiny). all buffers
+are allocated in the constructor, match() never allocates.
+
+  static ScanMatcher scanMatcher(1024);
+  static OnLidarFrameHandler onFrame = [](LidarFrame &frame){
+    ScanMatchResult motion;
+    if(scanMatcher.match(frame, motion)){
+      ...
+    }
+  };
+*/
+
+class ScanMatcher{
+  private:
+    struct ScanPoints{
+      float *xInMillimeter;
+      float *yInMillimeter;
+      float *normalX;   // 0/0 without normal
+      float *normalY;
+      size_t size;
+    };
+
+    size_t maxPoints;
+    size_t gridSize;      // cells per side of the hashed grid
+    ScanPoints scans[2];
+    ScanPoints *reference;
+    ScanPoints *current;
+    uint16_t *cellStart;  // gridSize*gridSize+1 offsets into sortedPoints
+    uint16_t *sortedPoints;
+
+    size_t maxIterations;
+    float maxCorrespondenceDistanceInMillimeter;
+    float neighbourDistanceInMillimeter;
+    size_t minCorrespondences;
+    float initialXInMillimeter;
+    float initialYInMillimeter;
+    float initialRotationInDegree;
+
+    void toPoints(const float anglesInDegree[], const float rangesInMillimeter[], size_t lenght, ScanPoints &scan);
+    void calculateNormals(ScanPoints &scan);
+    size_t cellOf(float xInMillimeter, float yInMillimeter);
+    int32_t cellCoordinate(float millimeter);
+    void buildGrid(const ScanPoints &scan);
+    bool findNearest(float x, float y, size_t &nearest);
+    static bool solve(const float h[3][3], const float b[3], float delta[3]);
+
+  public:
+    ScanMatcher(size_t maxPoints, size_t gridSize = 64);
+    ~ScanMatcher();
+    ScanMatcher(const ScanMatcher&) = delete;
+    ScanMatcher& operator=(const ScanMatcher&) = delete;
+
+    void setMaxIterations(size_t maxIterations);
+    void setMaxCorrespondenceDistance(float maxCorrespondenceDistanceInMillimeter);
+    void setMinCorrespondences(size_t minCorrespondences);
+    // start value of the next match only, e.g. from odometry
+    void setInitialGuess(float xInMillimeter, float yInMillimeter, float rotationInDegree);
+    void reset();
+
+    // returns result.isValid, samples above maxPoints are ignored
+    bool match(const LidarFrame &frame, ScanMatchResult &result);
+    bool match(const float anglesInDegree[], const float rangesInMillimeter[], size_t lenght, ScanMatchResult &result);
+};
+
+} // end namespace
+
+#endif
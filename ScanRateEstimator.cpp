@@ -0,0 +1,72 @@
+#include <ScanRateEstimator.h>
+
+namespace sensorYDLidarX4 {
+
+ScanRateEstimator::ScanRateEstimator(){
+  reset();
+}
+
+void ScanRateEstimator::reset(){
+  lastIndexTimeInMicros = 0;
+  hasIndexTime = false;
+  revolutionCount = 0;
+  rejectedPeriodCount = 0;
+  periodInMicros = 0;
+  jitterInMicros = 0;
+  samplesPerRevolution = 0;
+}
+
+void ScanRateEstimator::handleIndex(unsigned long timeInMicros, size_t samplesInRevolution){
+  unsigned long period = timeInMicros - lastIndexTimeInMicros;
+  bool isFirstIndex = !hasIndexTime;
+  lastIndexTimeInMicros = timeInMicros;
+  hasIndexTime = true;
+  if(isFirstIndex){
+    return;
+  }
+
+  if(period > 1.5f * periodInMicros && revolutionCount > 0){
+    if(++rejectedPeriodCount < maxRejectedPeriods){
+      return;
+    }
+    // not a lost index packet - the motor stays slow
+    revolutionCount = 0;
+  }
+  rejectedPeriodCount = 0;
+  if(revolutionCount++ == 0){
+    periodInMicros = period;
+    jitterInMicros = 0;
+    samplesPerRevolution = samplesInRevolution;
+    return;
+  }
+
+  float deviation = period - periodInMicros;
+  periodInMicros += deviation / 8;
+  jitterInMicros += ((deviation < 0 ? -deviation : deviation) - jitterInMicros) / 8;
+  samplesPerRevolution = samplesInRevolution;
+}
+
+float ScanRateEstimator::getFrequencyInHz(){
+  return periodInMicros > 0 ? 1000000.0f / periodInMicros : 0;
+}
+
+float ScanRateEstimator::getPeriodInMicros(){
+  return periodInMicros;
+}
+
+float ScanRateEstimator::getJitterInMicros(){
+  return jitterInMicros;
+}
+
+float ScanRateEstimator::getSamplePeriodInMicros(){
+  if(periodInMicros > 0 && samplesPerRevolution > 0){
+    return periodInMicros / samplesPerRevolution;
+  }
+  return defaultSamplePeriodInMicros;
+}
+
+unsigned long ScanRateEstimator::getLastIndexTimeInMicros(){
+  return lastIndexTimeInMicros;
+}
+
+} // end namespace
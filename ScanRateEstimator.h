@@ -0,0 +1,45 @@
+#ifndef __SCAN_RATE_ESTIMATOR__
+#define __SCAN_RATE_ESTIMATOR__
+
+#include <cstddef>
+
+namespace sensorYDLidarX4 {
+
+/*
+motor rotation frequency and jitter from the index packet cadence
+
+the revolution period is averaged with an exponential filter (1/8), the jitter
+is the filtered absolute deviation from it. a period of more than 1.5 times the
+average is a lost index packet and is ignored. after maxRejectedPeriods of them
+in a row the motor really got slower and the average starts again from the last
+period. the X4 turns with 6-12Hz, less points to a weak power supply.
+*/
+
+class ScanRateEstimator{
+  private:
+    const static unsigned long defaultSamplePeriodInMicros = 200; // 5000 samples/s
+    const static unsigned int maxRejectedPeriods = 3;
+
+    unsigned long lastIndexTimeInMicros;
+    bool hasIndexTime;
+    unsigned long revolutionCount;
+    unsigned int rejectedPeriodCount;
+    float periodInMicros;
+    float jitterInMicros;
+    size_t samplesPerRevolution;
+
+  public:
+    ScanRateEstimator();
+    void reset();
+    void handleIndex(unsigned long timeInMicros, size_t samplesInRevolution);
+
+    float getFrequencyInHz();
+    float getPeriodInMicros();
+    float getJitterInMicros();
+    float getSamplePeriodInMicros();
+    unsigned long getLastIndexTimeInMicros();
+};
+
+} // end namespace
+
+#endif
@@ -0,0 +1,260 @@
+#ifndef __STATIC_QUEUE__
+#define __STATIC_QUEUE__
+
+#include <cstring>
+#include <LidarQueue.h>
+using std::memcpy;
+
+namespace sensorYDLidarX4 {
+
+/*
+synchronized queue with compile time capacity
+
+the storage and the mutex are part of the object, so it can be placed in
+static memory and needs no heap at all. the capacity must be a power of two:
+head and tail are free running counters and are wrapped with a mask.
+
+  static StaticQueue<uint8_t, 1024> lidarQueue;
+  YDLidarX4::builder().setQueue(lidarQueue)...
+*/
+
+template <typename Type, size_t Capacity>
+class StaticQueue : public LidarQueue<Type>{
+  static_assert(Capacity > 0 && (Capacity & (Capacity-1)) == 0, "StaticQueue capacity must be a power of two");
+
+  private:
+    static const size_t mask = Capacity-1;
+    Type buffer[Capacity];
+    size_t head;
+    size_t tail;
+    StaticSemaphore_t lockBuffer;
+    SemaphoreHandle_t lock;
+
+    size_t wrap(size_t);
+
+  public:
+    StaticQueue();
+    bool add(Type element);
+    bool add(Type *elements, size_t size);
+    size_t reserve(Type *&span);
+    void commit(size_t size);
+    Type get(size_t index);
+    Type getRaw(size_t index);
+    Type dequeue();
+    bool extract(Type *targetBuffer, size_t size);
+    size_t peek(size_t offset, Type *targetBuffer, size_t size);
+    bool view(size_t size, LidarQueueView<Type> &view);
+    void remove(size_t sizeToRemove);
+    void clear();
+    bool isFull();
+    bool isEmpty();
+    size_t size();
+    size_t getCapacity();
+    size_t getHead();
+    size_t getTail();
+};
+
+template <typename Type, size_t Capacity>
+StaticQueue<Type, Capacity>::StaticQueue()
+  : head(0),
+  tail(0)
+{
+  lock = xSemaphoreCreateMutexStatic(&lockBuffer);
+}
+
+template <typename Type, size_t Capacity>
+inline size_t StaticQueue<Type, Capacity>::wrap(size_t index){
+  return index & mask;
+}
+
+template <typename Type, size_t Capacity>
+bool StaticQueue<Type, Capacity>::add(Type element){
+  bool dataWasAdded;
+  xSemaphoreTake(lock, portMAX_DELAY);
+  if(tail - head < Capacity){
+    buffer[wrap(tail++)] = element;
+    dataWasAdded = true;
+  }else{
+    dataWasAdded = false;
+  }
+  xSemaphoreGive(lock);
+  return dataWasAdded;
+}
+
+template <typename Type, size_t Capacity>
+bool StaticQueue<Type, Capacity>::add(Type *elements, size_t size){
+  bool dataWasAdded;
+  xSemaphoreTake(lock, portMAX_DELAY);
+  if(tail - head + size <= Capacity){
+    for(size_t i=0; i<size; i++){
+      buffer[wrap(tail++)] = elements[i];
+    }
+    dataWasAdded = true;
+  }else{
+    dataWasAdded = false;
+  }
+  xSemaphoreGive(lock);
+  return dataWasAdded;
+}
+
+template <typename Type, size_t Capacity>
+size_t StaticQueue<Type, Capacity>::reserve(Type *&span){
+  size_t spanSize;
+  xSemaphoreTake(lock, portMAX_DELAY);
+  size_t freeElements = Capacity - (tail - head);
+  size_t elementsUntilWrap = Capacity - wrap(tail);
+  spanSize = freeElements < elementsUntilWrap ? freeElements : elementsUntilWrap;
+  span = &buffer[wrap(tail)];
+  xSemaphoreGive(lock);
+  return spanSize;
+}
+
+template <typename Type, size_t Capacity>
+void StaticQueue<Type, Capacity>::commit(size_t size){
+  xSemaphoreTake(lock, portMAX_DELAY);
+  tail += size;
+  xSemaphoreGive(lock);
+}
+
+template <typename Type, size_t Capacity>
+Type StaticQueue<Type, Capacity>::get(size_t index){
+  Type element = Type();
+  xSemaphoreTake(lock, portMAX_DELAY);
+  if(index < tail - head){
+    element = buffer[wrap(head+index)];
+  }
+  xSemaphoreGive(lock);
+  return element;
+}
+
+template <typename Type, size_t Capacity>
+Type StaticQueue<Type, Capacity>::getRaw(size_t index){
+  return buffer[wrap(index)];
+}
+
+template <typename Type, size_t Capacity>
+Type StaticQueue<Type, Capacity>::dequeue(){
+  Type element = Type();
+  xSemaphoreTake(lock, portMAX_DELAY);
+  if(head != tail){
+    element = buffer[wrap(head++)];
+  }
+  xSemaphoreGive(lock);
+  return element;
+}
+
+template <typename Type, size_t Capacity>
+bool StaticQueue<Type, Capacity>::extract(Type *targetBuffer, size_t size){
+  bool isExtracted = false;
+  xSemaphoreTake(lock, portMAX_DELAY);
+  if(size <= tail - head){
+    size_t sizeOfFirstPart = Capacity - wrap(head);
+    if(size <= sizeOfFirstPart){
+      // normal - one block
+      memcpy(&targetBuffer[0], &buffer[wrap(head)], size * sizeof(Type));
+    }else{
+      // with wrap around - two blocks
+      memcpy(&targetBuffer[0], &buffer[wrap(head)], sizeOfFirstPart * sizeof(Type));
+      memcpy(&targetBuffer[sizeOfFirstPart], &buffer[0], (size-sizeOfFirstPart) * sizeof(Type));
+    }
+    head += size;
+    isExtracted = true;
+  }
+  xSemaphoreGive(lock);
+  return isExtracted;
+}
+
+template <typename Type, size_t Capacity>
+size_t StaticQueue<Type, Capacity>::peek(size_t offset, Type *targetBuffer, size_t size){
+  size_t peekedSize = 0;
+  xSemaphoreTake(lock, portMAX_DELAY);
+  size_t count = tail - head;
+  if(offset < count){
+    peekedSize = count-offset < size ? count-offset : size;
+    size_t start = wrap(head+offset);
+    size_t sizeOfFirstPart = Capacity - start;
+    if(peekedSize <= sizeOfFirstPart){
+      memcpy(&targetBuffer[0], &buffer[start], peekedSize * sizeof(Type));
+    }else{
+      memcpy(&targetBuffer[0], &buffer[start], sizeOfFirstPart * sizeof(Type));
+      memcpy(&targetBuffer[sizeOfFirstPart], &buffer[0], (peekedSize-sizeOfFirstPart) * sizeof(Type));
+    }
+  }
+  xSemaphoreGive(lock);
+  return peekedSize;
+}
+
+template <typename Type, size_t Capacity>
+bool StaticQueue<Type, Capacity>::view(size_t size, LidarQueueView<Type> &view){
+  bool isViewed = false;
+  xSemaphoreTake(lock, portMAX_DELAY);
+  if(size <= tail - head){
+    size_t sizeOfFirstPart = Capacity - wrap(head);
+    view.first = &buffer[wrap(head)];
+    view.second = &buffer[0];
+    if(size <= sizeOfFirstPart){
+      view.firstSize = size;
+      view.secondSize = 0;
+    }else{
+      view.firstSize = sizeOfFirstPart;
+      view.secondSize = size-sizeOfFirstPart;
+    }
+    isViewed = true;
+  }
+  xSemaphoreGive(lock);
+  return isViewed;
+}
+
+template <typename Type, size_t Capacity>
+void StaticQueue<Type, Capacity>::remove(size_t sizeToRemove){
+  xSemaphoreTake(lock, portMAX_DELAY);
+  if(sizeToRemove <= tail - head){
+    head += sizeToRemove;
+  }
+  xSemaphoreGive(lock);
+}
+
+template <typename Type, size_t Capacity>
+void StaticQueue<Type, Capacity>::clear(){
+  xSemaphoreTake(lock, portMAX_DELAY);
+  head = tail;
+  xSemaphoreGive(lock);
+}
+
+template <typename Type, size_t Capacity>
+bool StaticQueue<Type, Capacity>::isFull(){
+  return size() == Capacity;
+}
+
+template <typename Type, size_t Capacity>
+bool StaticQueue<Type, Capacity>::isEmpty(){
+  return size() == 0;
+}
+
+template <typename Type, size_t Capacity>
+size_t StaticQueue<Type, Capacity>::size(){
+  size_t result;
+  xSemaphoreTake(lock, portMAX_DELAY);
+  result = tail - head;
+  xSemaphoreGive(lock);
+  return result;
+}
+
+template <typename Type, size_t Capacity>
+size_t StaticQueue<Type, Capacity>::getCapacity(){
+  return Capacity;
+}
+
+template <typename Type, size_t Capacity>
+size_t StaticQueue<Type, Capacity>::getHead(){
+  return wrap(head);
+}
+
+template <typename Type, size_t Capacity>
+size_t StaticQueue<Type, Capacity>::getTail(){
+  return wrap(tail);
+}
+
+} // end namespace
+
+#endif
@@ -2,6 +2,7 @@
 #define __SYNCHRONIZED_QUEUE__
 
 #include <cstring>
+#include <LidarQueue.h>
 using std::memcpy;
 
 namespace sensorYDLidarX4 {
@@ -12,7 +13,7 @@ and provide a copy of selected size from the head
 */
 
 template <typename Type>
-class SynchronizedQueue{
+class SynchronizedQueue : public LidarQueue<Type>{
   private:
     size_t maxElements;
     Type* buffer;
@@ -28,10 +29,14 @@ class SynchronizedQueue{
     ~SynchronizedQueue();
     bool add(Type element);
     bool add(Type *elements, size_t size);
+    size_t reserve(Type *&span);
+    void commit(size_t size);
     Type get(size_t index);
     Type getRaw(size_t index);
     Type dequeue();
     bool extract(Type *targetBuffer, size_t size);
+    size_t peek(size_t offset, Type *targetBuffer, size_t size);
+    bool view(size_t size, LidarQueueView<Type> &view);
     void remove(size_t sizeToRemove);
     void clear();
     bool isFull();
@@ -97,6 +102,26 @@ bool SynchronizedQueue<Type>::add(Type *elements, size_t size){
   return dataWasAdded;
 }
 
+template <typename Type>
+size_t SynchronizedQueue<Type>::reserve(Type *&span){
+  size_t spanSize;
+  xSemaphoreTake(lock, portMAX_DELAY); 
+  size_t freeElements = maxElements - count;
+  size_t elementsUntilWrap = maxElements - tail;
+  spanSize = freeElements < elementsUntilWrap ? freeElements : elementsUntilWrap;
+  span = &buffer[tail];
+  xSemaphoreGive(lock);
+  return spanSize;
+}
+
+template <typename Type>
+void SynchronizedQueue<Type>::commit(size_t size){
+  xSemaphoreTake(lock, portMAX_DELAY); 
+  tail = wrap(tail + size);
+  count += size;
+  xSemaphoreGive(lock);
+}
+
 template <typename Type>
 Type SynchronizedQueue<Type>::get(size_t index){
   uint8_t element;
@@ -156,6 +181,46 @@ bool SynchronizedQueue<Type>::extract(Type *targetBuffer, size_t size){
   return isExtracted;
 }
 
+template <typename Type>
+size_t SynchronizedQueue<Type>::peek(size_t offset, Type *targetBuffer, size_t size){
+  size_t peekedSize = 0;
+  xSemaphoreTake(lock, portMAX_DELAY); 
+  if(offset < count){
+    peekedSize = count-offset < size ? count-offset : size;
+    size_t start = wrap(head+offset);
+    size_t sizeOfFirstPart = maxElements-start;
+    if(peekedSize <= sizeOfFirstPart){
+      memcpy(&targetBuffer[0], &buffer[start], peekedSize * sizeof(Type));
+    }else{
+      memcpy(&targetBuffer[0], &buffer[start], sizeOfFirstPart * sizeof(Type));
+      memcpy(&targetBuffer[sizeOfFirstPart], &buffer[0], (peekedSize-sizeOfFirstPart) * sizeof(Type));
+    }
+  }
+  xSemaphoreGive(lock); 
+  return peekedSize;
+}
+
+template <typename Type>
+bool SynchronizedQueue<Type>::view(size_t size, LidarQueueView<Type> &view){
+  bool isViewed = false;
+  xSemaphoreTake(lock, portMAX_DELAY); 
+  if(size <= count){
+    size_t sizeOfFirstPart = maxElements-head;
+    view.first = &buffer[head];
+    view.second = &buffer[0];
+    if(size <= sizeOfFirstPart){
+      view.firstSize = size;
+      view.secondSize = 0;
+    }else{
+      view.firstSize = sizeOfFirstPart;
+      view.secondSize = size-sizeOfFirstPart;
+    }
+    isViewed = true;
+  }
+  xSemaphoreGive(lock); 
+  return isViewed;
+}
+
 template <typename Type>
 void SynchronizedQueue<Type>::remove(size_t sizeToRemove){
   xSemaphoreTake(lock, portMAX_DELAY);
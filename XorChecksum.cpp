@@ -0,0 +1,64 @@
+#include <XorChecksum.h>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+using std::memcpy;
+
+namespace sensorYDLidarX4 {
+
+uint16_t xorChecksum16(const uint8_t *data, size_t length){
+  size_t position = 0;
+  uint64_t wide = 0;
+
+#if defined(__SSE2__)
+  __m128i accumulator = _mm_setzero_si128();
+  for(; position+16 <= length; position+=16){
+    accumulator = _mm_xor_si128(accumulator, _mm_loadu_si128((const __m128i*)(data+position)));
+  }
+  uint64_t lanes[2];
+  _mm_storeu_si128((__m128i*)lanes, accumulator);
+  wide = lanes[0] ^ lanes[1];
+#elif defined(__ARM_NEON)
+  uint8x16_t accumulator = vdupq_n_u8(0);
+  for(; position+16 <= length; position+=16){
+    accumulator = veorq_u8(accumulator, vld1q_u8(data+position));
+  }
+  uint64x2_t lanes = vreinterpretq_u64_u8(accumulator);
+  wide = vgetq_lane_u64(lanes, 0) ^ vgetq_lane_u64(lanes, 1);
+#else
+  // two independent accumulators keep the load/xor pipeline busy
+  uint32_t accumulator0 = 0;
+  uint32_t accumulator1 = 0;
+  for(; position+8 <= length; position+=8){
+    uint32_t word0, word1;
+    memcpy(&word0, data+position, sizeof(word0));
+    memcpy(&word1, data+position+4, sizeof(word1));
+    accumulator0 ^= word0;
+    accumulator1 ^= word1;
+  }
+  wide = accumulator0 ^ accumulator1;
+#endif
+
+  // fold 64 -> 16 bit, every position stays aligned to 2 bytes
+  wide ^= wide >> 32;
+  wide ^= wide >> 16;
+  uint16_t checksum = (uint16_t)wide;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  checksum = (uint16_t)((checksum << 8) | (checksum >> 8));
+#endif
+
+  for(; position+2 <= length; position+=2){
+    checksum ^= data[position] | (data[position+1] << 8);
+  }
+  if(position < length){
+    checksum ^= data[position];
+  }
+  return checksum;
+}
+
+} // end namespace
@@ -0,0 +1,16 @@
+#ifndef __XOR_CHECKSUM__
+#define __XOR_CHECKSUM__
+
+#include <cstdint>
+#include <cstddef>
+
+namespace sensorYDLidarX4 {
+
+// XOR of all little endian 16 bit words of data, which has to start at an even paket position.
+// an odd last byte is XORed into the low byte.
+// uses SSE2/NEON when available and a 32 bit scalar loop otherwise (ESP32)
+uint16_t xorChecksum16(const uint8_t *data, size_t length);
+
+} // end namespace
+
+#endif
@@ -8,24 +8,88 @@
 
 namespace sensorYDLidarX4 {
 
-YDLidarX4::YDLidarX4(Stream *serial, OnLidarPacketHandler *packetHandler, OnLidarIndexPacketHandler *indexPacketHandler, unsigned long _timeoutInMilliseconds, bool autoRestart, int _motorEnablePin, uint16_t maxQueueElements, Print *debug, Print *trace, LogLevel logLevel)
-  : serial(serial),
-  debug(debug),
-  trace(trace),
-  logLevel(logLevel),
-  queue(SynchronizedQueue<uint8_t>(maxQueueElements)),
-  stateMachine(queue, packetHandler, indexPacketHandler, debug, trace, logLevel),
-  timeoutInMilliseconds(_timeoutInMilliseconds),
-  autoRestart(autoRestart),
-  motorEnablePin(_motorEnablePin)
+YDLidarX4::YDLidarX4(const YDLidarX4Builder &builder)
+  : serial(builder.serial),
+  debug(builder.debug),
+  trace(builder.trace),
+  logLevel(builder.logLevel),
+  queue(builder.externalQueue != nullptr ? builder.externalQueue : createQueue(builder.queueType, builder.maxQueueElements)),
+  isQueueOwner(builder.externalQueue == nullptr),
+  frameAssembler(builder.frameHandler != nullptr ? new FrameAssembler(builder.maxFrameSamples) : nullptr),
+  receiveTimestamps(new ReceiveTimestamps(queue->getCapacity())),
+  stateMachine(*queue, builder.packetHandler, builder.indexPacketHandler, builder.debug, builder.trace, builder.logLevel),
+  timeoutInMilliseconds(builder.timeoutInMilliseconds),
+  autoRestart(builder.autoRestart),
+  motorEnablePin(builder.motorEnablePin)
 {
   // REMINDER do not use debug->print in construtor
+  stateMachine.setResyncOnError(builder.resyncOnError);
+  stateMachine.setAngleCorrectionMode(builder.angleCorrectionMode);
+  stateMachine.setFixedPointPacketHandler(builder.fixedPointPacketHandler);
+  stateMachine.setPacketCallback(builder.packetCallback, builder.packetCallbackContext);
+  stateMachine.setFixedPointPacketCallback(builder.fixedPointPacketCallback, builder.fixedPointPacketCallbackContext);
+  stateMachine.setReceiveTimestamps(receiveTimestamps);
+  stateMachine.setTimedPacketHandler(builder.timedPacketHandler);
+  stateMachine.setFrameHandler(frameAssembler, builder.frameHandler);
+  stateMachine.setClusterExtractor(builder.clusterExtractor);
+  stateMachine.setPolarGrid(builder.polarGrid);
+  stateMachine.setNearestObstacleTracker(builder.nearestObstacleTracker);
+  stateMachine.setOccupancyGrid(builder.occupancyGrid);
+  stateMachine.setRangeFilter(builder.rangeFilter);
+  stateMachine.setAngularRoi(builder.angularRoi);
+  stateMachine.setDecimator(builder.decimator);
+  stateMachine.setPointCloudHandlers(builder.pointCloudHandler, builder.floatPointCloudHandler);
+  stateMachine.setMountingOffset(builder.mountingOffsetXInMillimeter, builder.mountingOffsetYInMillimeter, builder.mountingRotationInDegree);
+  stateMachine.setResponseHandlers(builder.healthStatusHandler, builder.deviceInfoHandler);
   trySetPinMode();
   tryDisableMotor();
 }
 
+// the state machine keeps pointing to the heap objects, the moved from lidar gives up their ownership
+YDLidarX4::YDLidarX4(YDLidarX4 &&other)
+  : queue(other.queue),
+  isQueueOwner(other.isQueueOwner),
+  frameAssembler(other.frameAssembler),
+  receiveTimestamps(other.receiveTimestamps),
+  stateMachine(std::move(other.stateMachine)),
+  serial(other.serial),
+  maxQueueElements(other.maxQueueElements),
+  debug(other.debug),
+  trace(other.trace),
+  logLevel(other.logLevel),
+  motorEnablePin(other.motorEnablePin),
+  timeoutInMilliseconds(other.timeoutInMilliseconds),
+  autoRestart(other.autoRestart),
+  statMaxLidarQueueSize(other.statMaxLidarQueueSize),
+  statLastTimeReceivedData(other.statLastTimeReceivedData),
+  statIngestCalls(other.statIngestCalls),
+  statIngestedBytes(other.statIngestedBytes),
+  statMaxBytesPerIngest(other.statMaxBytesPerIngest)
+{
+  other.queue = nullptr;
+  other.isQueueOwner = false;
+  other.frameAssembler = nullptr;
+  other.receiveTimestamps = nullptr;
+}
+
 YDLidarX4::~YDLidarX4(){
+  if(queue == nullptr){
+    // moved from
+    return;
+  }
   stop();
+  if(isQueueOwner){
+    delete queue;
+  }
+  delete frameAssembler;
+  delete receiveTimestamps;
+}
+
+LidarQueue<uint8_t>* YDLidarX4::createQueue(QueueType queueType, uint16_t maxQueueElements){
+  switch (queueType){
+    case QUEUE_LOCK_FREE:   return new LockFreeQueue<uint8_t>(maxQueueElements);
+    default:                return new SynchronizedQueue<uint8_t>(maxQueueElements);
+  }
 }
 
 YDLidarX4::YDLidarX4Builder YDLidarX4::builder(){
@@ -34,8 +98,12 @@ YDLidarX4::YDLidarX4Builder YDLidarX4::builder(){
 
 // --- motor handling -----------------------------------------------------------------------------
 bool YDLidarX4::start(){
+  // logged here, the constructor must not print
+  IF_DEBUG if(stateMachine.hasAngleCorrectionFallback()){
+    debug->printf("angle correction table does not fit into the heap - using the interpolated table\n");
+  }
   stateMachine.setStateIdle();
-  // queue.clear();
+  // queue->clear();
   
   int availableBytes = serial->available();
   for(int byteCount=0; byteCount<availableBytes; byteCount++){
@@ -132,22 +200,34 @@ bool YDLidarX4::doReceive(){
 }
 
 bool YDLidarX4::tryReceiveAllBytes(){
+  // one timestamp for all bytes of this call
+  unsigned long receiveTimeInMicros = micros();
+  size_t receivedBytes = 0;
   int availableBytes = serial->available();
-  for(int byteCount=0; byteCount<availableBytes; byteCount++){
-
-    int data = serial->read();
-    if(data == -1){
+  while(availableBytes > 0){
+    uint8_t *span;
+    size_t spanSize = queue->reserve(span);
+    if(spanSize == 0){
+      IF_DEBUG debug->printf("\n--> could not add data to lidar queue\n\n");
+      stateMachine.setStateError();
+      handleIngestStats(receivedBytes);
       return false;
     }
 
-    uint8_t byteFromLidar = (uint8_t)data;
-    bool hasDataAdded = queue.add(byteFromLidar);
-    if(!hasDataAdded){
-      IF_DEBUG debug->printf("\n--> could not add data to lidar queue\n\n");
-      stateMachine.setStateError();
+    size_t bytesToRead = spanSize < (size_t)availableBytes ? spanSize : (size_t)availableBytes;
+    size_t bytesRead = serial->readBytes(span, bytesToRead);
+    queue->commit(bytesRead);
+    if(!receiveTimestamps->add(bytesRead, receiveTimeInMicros)){
+      IF_DEBUG debug->printf("\n--> could not add receive timestamp\n\n");
+    }
+    receivedBytes += bytesRead;
+    if(bytesRead < bytesToRead){
+      handleIngestStats(receivedBytes);
       return false;
     }
+    availableBytes -= bytesRead;
   }
+  handleIngestStats(receivedBytes);
   return true;
 }
 
@@ -155,16 +235,27 @@ bool YDLidarX4::tryReceiveAllBytes(){
 void YDLidarX4::initializeLidarStats(){
   statLastTimeReceivedData = millis();
   statMaxLidarQueueSize = 0;
+  statIngestCalls = 0;
+  statIngestedBytes = 0;
+  statMaxBytesPerIngest = 0;
 }
 
 void YDLidarX4::handleLidarStats(){
   statLastTimeReceivedData = millis();
-  uint16_t queueSize = queue.size();
+  uint16_t queueSize = queue->size();
   if(queueSize > statMaxLidarQueueSize){
     statMaxLidarQueueSize = queueSize;
   }
 }
 
+void YDLidarX4::handleIngestStats(size_t receivedBytes){
+  statIngestCalls++;
+  statIngestedBytes += receivedBytes;
+  if(receivedBytes > statMaxBytesPerIngest){
+    statMaxBytesPerIngest = receivedBytes;
+  }
+}
+
 // --- run/runOnce function -----------------------------------------------------------------------
 void YDLidarX4::run(){
   while(runOnce());
@@ -178,12 +269,22 @@ bool YDLidarX4::runOnce(){
   return isStateChanged;
 }
 
+// decodes all complete pakets of the queue in one go and runs the housekeeping
+// (error, timeout) only once per batch - returns the count of decoded pakets
+size_t YDLidarX4::runBatch(){
+  size_t decodedPakets = stateMachine.runBatch();
+  handleError();
+  handleTimeout();
+  checkReceiveTimeout();
+  return decodedPakets;
+}
+
 void YDLidarX4::handleError(){
   if(!stateMachine.hasError()){
     return;
   }
 
-  IF_DEBUG debug->printf("lidar has an error - stopping with queue size of %lu Bytes\n", queue.size());
+  IF_DEBUG debug->printf("lidar has an error - stopping with queue size of %lu Bytes\n", queue->size());
   stop();
 
   const char* horizontalRow = string(90, '#').c_str();
@@ -223,7 +324,7 @@ void YDLidarX4::checkReceiveTimeout(){
     IF_DEBUG debug->printf("| ********* TIMEOUT detected\n");
     IF_DEBUG debug->printf("| state:%s isScanning:%d\n", stateMachine.getState().c_str(), stateMachine.isScanning());
     IF_DEBUG debug->printf("|\n");
-    IF_DEBUG debug->printf("| lidar has an timeout - QueueSize(capacity/maxUsed/currentUsed):%lu/%lu/%lu\n", queue.getCapacity(), statMaxLidarQueueSize, queue.size());
+    IF_DEBUG debug->printf("| lidar has an timeout - QueueSize(capacity/maxUsed/currentUsed):%lu/%lu/%lu\n", queue->getCapacity(), statMaxLidarQueueSize, queue->size());
     IF_DEBUG debug->printf("\\--------------------------\n");
 
     stateMachine.setStateTimeout();
@@ -236,7 +337,7 @@ bool YDLidarX4::isScanning(){
 }
 
 size_t YDLidarX4::getQueueSize(){
-  return queue.size();
+  return queue->size();
 }
 
 size_t YDLidarX4::getMaxUsedQueueSize(){
@@ -244,7 +345,56 @@ size_t YDLidarX4::getMaxUsedQueueSize(){
 }
 
 size_t YDLidarX4::getQueueCapacity(){
-  return queue.getCapacity();
+  return queue->getCapacity();
+}
+
+unsigned long YDLidarX4::getDecodedPacketCount(){
+  return stateMachine.getDecodedPaketCount();
+}
+
+uint16_t YDLidarX4::getRevolutionCount(){
+  return stateMachine.getRevolutionCount();
+}
+
+// motor rotation frequency estimated from the index packets, 0 until two index packets were received
+float YDLidarX4::getScanFrequencyInHz(){
+  return stateMachine.getScanFrequencyInHz();
+}
+
+float YDLidarX4::getScanPeriodJitterInMicros(){
+  return stateMachine.getScanPeriodJitterInMicros();
+}
+
+unsigned long YDLidarX4::getLastIndexPacketTimeInMicros(){
+  return stateMachine.getLastIndexPacketTimeInMicros();
+}
+
+unsigned long YDLidarX4::getResyncCount(){
+  return stateMachine.getResyncCount();
+}
+
+unsigned long YDLidarX4::getResyncDiscardedBytes(){
+  return stateMachine.getResyncDiscardedBytes();
+}
+
+unsigned long YDLidarX4::getIngestCallCount(){
+  return statIngestCalls;
+}
+
+unsigned long YDLidarX4::getIngestedByteCount(){
+  return statIngestedBytes;
+}
+
+size_t YDLidarX4::getMaxBytesPerIngest(){
+  return statMaxBytesPerIngest;
+}
+
+float YDLidarX4::getAverageBytesPerIngest(){
+  unsigned long calls = statIngestCalls;
+  if(calls == 0){
+    return 0;
+  }
+  return (float)statIngestedBytes / calls;
 }
 
 string YDLidarX4::getState(){
@@ -271,10 +421,36 @@ void YDLidarX4::setLogLevel(LogLevel logLevel){
 YDLidarX4::YDLidarX4Builder::YDLidarX4Builder()
   : timeoutInMilliseconds(1000),
   autoRestart(true),
+  resyncOnError(false),
+  angleCorrectionMode(ANGLE_CORRECTION_EXACT),
   serial(nullptr),
   packetHandler(nullptr),
   indexPacketHandler(nullptr),
+  fixedPointPacketHandler(nullptr),
+  packetCallback(nullptr),
+  packetCallbackContext(nullptr),
+  fixedPointPacketCallback(nullptr),
+  fixedPointPacketCallbackContext(nullptr),
+  timedPacketHandler(nullptr),
+  frameHandler(nullptr),
+  maxFrameSamples(1024),  // a revolution at 6Hz has about 850 samples
+  clusterExtractor(nullptr),
+  polarGrid(nullptr),
+  nearestObstacleTracker(nullptr),
+  occupancyGrid(nullptr),
+  rangeFilter(nullptr),
+  angularRoi(nullptr),
+  decimator(nullptr),
+  pointCloudHandler(nullptr),
+  floatPointCloudHandler(nullptr),
+  mountingOffsetXInMillimeter(0),
+  mountingOffsetYInMillimeter(0),
+  mountingRotationInDegree(0),
+  healthStatusHandler(nullptr),
+  deviceInfoHandler(nullptr),
   maxQueueElements(360),  // should handle at least almost 3 complete serial data blocks = 3*120bytes
+  queueType(QUEUE_SYNCHRONIZED),
+  externalQueue(nullptr),
   debug(&DummyPrint),
   trace(&DummyPrint),
   logLevel(LOG_NONE),
@@ -283,11 +459,11 @@ YDLidarX4::YDLidarX4Builder::YDLidarX4Builder()
 }
 
 YDLidarX4 YDLidarX4::YDLidarX4Builder::build(){
-  return YDLidarX4(serial, packetHandler, indexPacketHandler, timeoutInMilliseconds, autoRestart, motorEnablePin, maxQueueElements, debug, trace, logLevel);
+  return YDLidarX4(*this);
 }
 
 YDLidarX4* YDLidarX4::YDLidarX4Builder::buildPtr(){
-  return new YDLidarX4(serial, packetHandler, indexPacketHandler, timeoutInMilliseconds, autoRestart, motorEnablePin, maxQueueElements, debug, trace, logLevel);
+  return new YDLidarX4(*this);
 }
 
 YDLidarX4::YDLidarX4Builder& YDLidarX4::YDLidarX4Builder::setSerialDevice(Stream &serial){
@@ -305,11 +481,130 @@ YDLidarX4::YDLidarX4Builder& YDLidarX4::YDLidarX4Builder::setIndexPacketHandler(
   return *this;
 }
 
+// delivers angles in 1/64 degree and ranges in 0.25mm without any float calculation
+YDLidarX4::YDLidarX4Builder& YDLidarX4::YDLidarX4Builder::setFixedPointPacketHandler(OnLidarFixedPointPacketHandler &fixedPointPacketHandler){
+  this->fixedPointPacketHandler = &fixedPointPacketHandler; 
+  return *this;
+}
+
+// function pointer variant of setPacketHandler without std::function, gets all pakets (index packets with lenght 1)
+YDLidarX4::YDLidarX4Builder& YDLidarX4::YDLidarX4Builder::setPacketCallback(LidarPacketCallback packetCallback, void *context){
+  this->packetCallback = packetCallback;
+  this->packetCallbackContext = context;
+  return *this;
+}
+
+YDLidarX4::YDLidarX4Builder& YDLidarX4::YDLidarX4Builder::setFixedPointPacketCallback(LidarFixedPointPacketCallback fixedPointPacketCallback, void *context){
+  this->fixedPointPacketCallback = fixedPointPacketCallback;
+  this->fixedPointPacketCallbackContext = context;
+  return *this;
+}
+
+// like setPacketHandler, but with the receive time of the paket and the time of its samples
+YDLidarX4::YDLidarX4Builder& YDLidarX4::YDLidarX4Builder::setTimedPacketHandler(OnLidarTimedPacketHandler &timedPacketHandler){
+  this->timedPacketHandler = &timedPacketHandler; 
+  return *this;
+}
+
+// delivers full revolutions instead of single pakets, the frame stays valid until the next one is finished
+YDLidarX4::YDLidarX4Builder& YDLidarX4::YDLidarX4Builder::setFrameHandler(OnLidarFrameHandler &frameHandler){
+  this->frameHandler = &frameHandler; 
+  return *this;
+}
+
+YDLidarX4::YDLidarX4Builder& YDLidarX4::YDLidarX4Builder::setMaxFrameSamples(size_t maxFrameSamples){
+  this->maxFrameSamples = maxFrameSamples; 
+  return *this;
+}
+
+// the (user owned) extractor is fed paket by paket and calls its handler on every index packet
+YDLidarX4::YDLidarX4Builder& YDLidarX4::YDLidarX4Builder::setClusterExtractor(ClusterExtractor &clusterExtractor){
+  this->clusterExtractor = &clusterExtractor; 
+  return *this;
+}
+
+// every sample is written into its bin of the (user owned) grid
+YDLidarX4::YDLidarX4Builder& YDLidarX4::YDLidarX4Builder::setPolarGrid(PolarGrid &polarGrid){
+  this->polarGrid = &polarGrid; 
+  return *this;
+}
+
+// the threshold events of the (user owned) tracker are checked after every paket
+YDLidarX4::YDLidarX4Builder& YDLidarX4::YDLidarX4Builder::setNearestObstacleTracker(NearestObstacleTracker &nearestObstacleTracker){
+  this->nearestObstacleTracker = &nearestObstacleTracker; 
+  return *this;
+}
+
+// every sample is ray traced into the (user owned) grid
+YDLidarX4::YDLidarX4Builder& YDLidarX4::YDLidarX4Builder::setOccupancyGrid(OccupancyGrid &occupancyGrid){
+  this->occupancyGrid = &occupancyGrid; 
+  return *this;
+}
+
+// delivers x/y points, the sin/cos is read from a table inside the library
+YDLidarX4::YDLidarX4Builder& YDLidarX4::YDLidarX4Builder::setPointCloudHandler(OnLidarPointCloudHandler &pointCloudHandler){
+  this->pointCloudHandler = &pointCloudHandler; 
+  return *this;
+}
+
+YDLidarX4::YDLidarX4Builder& YDLidarX4::YDLidarX4Builder::setFloatPointCloudHandler(OnLidarFloatPointCloudHandler &floatPointCloudHandler){
+  this->floatPointCloudHandler = &floatPointCloudHandler; 
+  return *this;
+}
+
+// position and rotation (counter clockwise) of the lidar on the robot, used by the point cloud handlers
+YDLidarX4::YDLidarX4Builder& YDLidarX4::YDLidarX4Builder::setMountingOffset(int16_t offsetXInMillimeter, int16_t offsetYInMillimeter, float rotationInDegree){
+  this->mountingOffsetXInMillimeter = offsetXInMillimeter;
+  this->mountingOffsetYInMillimeter = offsetYInMillimeter;
+  this->mountingRotationInDegree = rotationInDegree;
+  return *this;
+}
+
+// filters the float ranges before they are passed to the handlers and frames
+YDLidarX4::YDLidarX4Builder& YDLidarX4::YDLidarX4Builder::setRangeFilter(RangeFilter &rangeFilter){
+  this->rangeFilter = &rangeFilter; 
+  return *this;
+}
+
+// pakets outside the sectors are skipped before they are decoded
+YDLidarX4::YDLidarX4Builder& YDLidarX4::YDLidarX4Builder::setAngularRoi(AngularRoi &angularRoi){
+  this->angularRoi = &angularRoi; 
+  return *this;
+}
+
+// reduces the samples of the selected pakets before they are converted
+YDLidarX4::YDLidarX4Builder& YDLidarX4::YDLidarX4Builder::setDecimator(Decimator &decimator){
+  this->decimator = &decimator; 
+  return *this;
+}
+
+YDLidarX4::YDLidarX4Builder& YDLidarX4::YDLidarX4Builder::setHealthStatusHandler(OnLidarHealthStatusHandler &healthStatusHandler){
+  this->healthStatusHandler = &healthStatusHandler; 
+  return *this;
+}
+
+YDLidarX4::YDLidarX4Builder& YDLidarX4::YDLidarX4Builder::setDeviceInfoHandler(OnLidarDeviceInfoHandler &deviceInfoHandler){
+  this->deviceInfoHandler = &deviceInfoHandler; 
+  return *this;
+}
+
 YDLidarX4::YDLidarX4Builder& YDLidarX4::YDLidarX4Builder::setMaxQueueElements(uint16_t maxQueueElements){
   this->maxQueueElements = maxQueueElements; 
   return *this;
 }
 
+YDLidarX4::YDLidarX4Builder& YDLidarX4::YDLidarX4Builder::setQueueType(QueueType queueType){
+  this->queueType = queueType; 
+  return *this;
+}
+
+// the queue is not owned by the lidar, e.g. a StaticQueue in static memory
+// maxQueueElements and queueType are ignored in this case
+YDLidarX4::YDLidarX4Builder& YDLidarX4::YDLidarX4Builder::setQueue(LidarQueue<uint8_t> &queue){
+  this->externalQueue = &queue; 
+  return *this;
+}
+
 YDLidarX4::YDLidarX4Builder& YDLidarX4::YDLidarX4Builder::setTimeoutInMilliseconds(unsigned long timeoutInMilliseconds){
   this->timeoutInMilliseconds = timeoutInMilliseconds; 
   return *this;
@@ -320,6 +615,17 @@ YDLidarX4::YDLidarX4Builder& YDLidarX4::YDLidarX4Builder::setAutoRestartOnTimeou
   return *this;
 }
 
+// scan forward to the next paket header on garbage bytes or crc errors instead of stopping the lidar
+YDLidarX4::YDLidarX4Builder& YDLidarX4::YDLidarX4Builder::setResyncOnError(bool resyncOnError){
+  this->resyncOnError = resyncOnError; 
+  return *this;
+}
+
+YDLidarX4::YDLidarX4Builder& YDLidarX4::YDLidarX4Builder::setAngleCorrectionMode(AngleCorrectionMode angleCorrectionMode){
+  this->angleCorrectionMode = angleCorrectionMode; 
+  return *this;
+}
+
 YDLidarX4::YDLidarX4Builder& YDLidarX4::YDLidarX4Builder::setMotorEnablePin(int motorEnablePin){
   this->motorEnablePin = motorEnablePin; 
   return *this;
@@ -2,10 +2,16 @@
 #define __YD_LIDAR_X4__
 
 #include <YDLidarX4StateMachine.h>
+#include <LidarQueue.h>
 #include <SynchronizedQueue.h>
+#include <LockFreeQueue.h>
+#include <StaticQueue.h>
 #include <string>
+#include <utility>
 #include <DummyPrint.h>
 #include <LogLevel.h>
+#include <QueueType.h>
+#include <AngleCorrectionMode.h>
 
 using std::string;
 
@@ -23,7 +29,10 @@ private:
   uint8_t LIDAR_HEALTH_STATUS_CMD[2] = {0xA5, 0x91};
   uint8_t LIDAR_SOFT_REBOOT_CMD[2]   = {0xA5, 0x80};
 
-  SynchronizedQueue<uint8_t> queue;
+  LidarQueue<uint8_t> *queue;
+  bool isQueueOwner;
+  FrameAssembler *frameAssembler;
+  ReceiveTimestamps *receiveTimestamps;
 
   // internal variables
   YDLidarX4StateMachine stateMachine;
@@ -40,20 +49,29 @@ private:
   bool tryDisableMotor();
   bool tryEnableMotor();
   bool tryReceiveAllBytes();
+  static LidarQueue<uint8_t>* createQueue(QueueType queueType, uint16_t maxQueueElements);
 
   // stats
   volatile uint16_t statMaxLidarQueueSize;
   volatile unsigned long statLastTimeReceivedData;
+  volatile unsigned long statIngestCalls;
+  volatile unsigned long statIngestedBytes;
+  volatile size_t statMaxBytesPerIngest;
   void initializeLidarStats();
   void handleLidarStats();
+  void handleIngestStats(size_t receivedBytes);
 
   template<typename TYPENAME, std::size_t SIZE>
   size_t sendCmd(TYPENAME (&cmd)[SIZE]);
 
-  YDLidarX4(Stream *lidarSerial, OnLidarPacketHandler *packetHandler, OnLidarIndexPacketHandler *indexPacketHandler, unsigned long timeoutInMilliseconds, bool autoRestart, int motorEnablePin, uint16_t maxQueueElements, Print *debug, Print *trace, LogLevel logLevel);
   class YDLidarX4Builder;
+  YDLidarX4(const YDLidarX4Builder &builder);
 
 public:
+  // owns the queue and its buffers, so it can only be moved (build() returns by value)
+  YDLidarX4(const YDLidarX4&) = delete;
+  YDLidarX4& operator=(const YDLidarX4&) = delete;
+  YDLidarX4(YDLidarX4 &&other);
   ~YDLidarX4();
   static YDLidarX4Builder builder();
 
@@ -66,6 +84,7 @@ public:
   bool doReceive();
   void run();
   bool runOnce();
+  size_t runBatch();
   void handleError();
   void handleTimeout();
   void checkReceiveTimeout();
@@ -75,6 +94,17 @@ public:
   size_t getQueueSize();
   size_t getMaxUsedQueueSize();
   size_t getQueueCapacity();
+  unsigned long getDecodedPacketCount();
+  uint16_t getRevolutionCount();
+  float getScanFrequencyInHz();
+  float getScanPeriodJitterInMicros();
+  unsigned long getLastIndexPacketTimeInMicros();
+  unsigned long getResyncCount();
+  unsigned long getResyncDiscardedBytes();
+  unsigned long getIngestCallCount();
+  unsigned long getIngestedByteCount();
+  size_t getMaxBytesPerIngest();
+  float getAverageBytesPerIngest();
   string getState();
 
   void debugPrintQueue();
@@ -83,13 +113,41 @@ public:
 };
 
 class YDLidarX4::YDLidarX4Builder{
+  friend class YDLidarX4;
+
   private:
     Stream *serial;
     OnLidarPacketHandler *packetHandler;
     OnLidarIndexPacketHandler *indexPacketHandler;
+    OnLidarFixedPointPacketHandler *fixedPointPacketHandler;
+    LidarPacketCallback packetCallback;
+    void *packetCallbackContext;
+    LidarFixedPointPacketCallback fixedPointPacketCallback;
+    void *fixedPointPacketCallbackContext;
+    OnLidarTimedPacketHandler *timedPacketHandler;
+    OnLidarFrameHandler *frameHandler;
+    size_t maxFrameSamples;
+    ClusterExtractor *clusterExtractor;
+    PolarGrid *polarGrid;
+    NearestObstacleTracker *nearestObstacleTracker;
+    OccupancyGrid *occupancyGrid;
+    RangeFilter *rangeFilter;
+    AngularRoi *angularRoi;
+    Decimator *decimator;
+    OnLidarPointCloudHandler *pointCloudHandler;
+    OnLidarFloatPointCloudHandler *floatPointCloudHandler;
+    int16_t mountingOffsetXInMillimeter;
+    int16_t mountingOffsetYInMillimeter;
+    float mountingRotationInDegree;
+    OnLidarHealthStatusHandler *healthStatusHandler;
+    OnLidarDeviceInfoHandler *deviceInfoHandler;
     uint16_t maxQueueElements;
+    QueueType queueType;
+    LidarQueue<uint8_t> *externalQueue;
     unsigned long timeoutInMilliseconds;
     bool autoRestart;
+    bool resyncOnError;
+    AngleCorrectionMode angleCorrectionMode;
     int motorEnablePin;
     Print *debug;
     Print *trace;
@@ -103,9 +161,31 @@ class YDLidarX4::YDLidarX4Builder{
     YDLidarX4Builder& setSerialDevice(Stream &serial);
     YDLidarX4Builder& setPacketHandler(OnLidarPacketHandler &packetHandler);
     YDLidarX4Builder& setIndexPacketHandler(OnLidarIndexPacketHandler &indexPacketHandler);
+    YDLidarX4Builder& setFixedPointPacketHandler(OnLidarFixedPointPacketHandler &fixedPointPacketHandler);
+    YDLidarX4Builder& setPacketCallback(LidarPacketCallback packetCallback, void *context = nullptr);
+    YDLidarX4Builder& setFixedPointPacketCallback(LidarFixedPointPacketCallback fixedPointPacketCallback, void *context = nullptr);
+    YDLidarX4Builder& setTimedPacketHandler(OnLidarTimedPacketHandler &timedPacketHandler);
+    YDLidarX4Builder& setFrameHandler(OnLidarFrameHandler &frameHandler);
+    YDLidarX4Builder& setMaxFrameSamples(size_t maxFrameSamples);
+    YDLidarX4Builder& setClusterExtractor(ClusterExtractor &clusterExtractor);
+    YDLidarX4Builder& setPolarGrid(PolarGrid &polarGrid);
+    YDLidarX4Builder& setNearestObstacleTracker(NearestObstacleTracker &nearestObstacleTracker);
+    YDLidarX4Builder& setOccupancyGrid(OccupancyGrid &occupancyGrid);
+    YDLidarX4Builder& setRangeFilter(RangeFilter &rangeFilter);
+    YDLidarX4Builder& setAngularRoi(AngularRoi &angularRoi);
+    YDLidarX4Builder& setDecimator(Decimator &decimator);
+    YDLidarX4Builder& setPointCloudHandler(OnLidarPointCloudHandler &pointCloudHandler);
+    YDLidarX4Builder& setFloatPointCloudHandler(OnLidarFloatPointCloudHandler &floatPointCloudHandler);
+    YDLidarX4Builder& setMountingOffset(int16_t offsetXInMillimeter, int16_t offsetYInMillimeter, float rotationInDegree);
+    YDLidarX4Builder& setHealthStatusHandler(OnLidarHealthStatusHandler &healthStatusHandler);
+    YDLidarX4Builder& setDeviceInfoHandler(OnLidarDeviceInfoHandler &deviceInfoHandler);
     YDLidarX4Builder& setMaxQueueElements(uint16_t maxQueueElements);
+    YDLidarX4Builder& setQueueType(QueueType queueType);
+    YDLidarX4Builder& setQueue(LidarQueue<uint8_t> &queue);
     YDLidarX4Builder& setTimeoutInMilliseconds(unsigned long timeoutInMilliseconds);
     YDLidarX4Builder& setAutoRestartOnTimeout(bool autoRestart);
+    YDLidarX4Builder& setResyncOnError(bool resyncOnError);
+    YDLidarX4Builder& setAngleCorrectionMode(AngleCorrectionMode angleCorrectionMode);
     YDLidarX4Builder& setMotorEnablePin(int motorEnablePin);
     YDLidarX4Builder& setDebug(Print &debug);
     YDLidarX4Builder& setTrace(Print &trace);
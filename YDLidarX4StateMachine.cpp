@@ -1,5 +1,8 @@
 #include <YDLidarX4StateMachine.h>
 #include <DummyPrint.h>
+#include <XorChecksum.h>
+#include <AngleInterpolation.h>
+#include <cstring>
 
 using std::to_string;
 
@@ -11,14 +14,42 @@ using std::to_string;
 
 namespace sensorYDLidarX4 {
 
-YDLidarX4StateMachine::YDLidarX4StateMachine(SynchronizedQueue<uint8_t> &queue, OnLidarPacketHandler *packetHandler, OnLidarIndexPacketHandler *indexPacketHandler, Print *debug, Print *trace, LogLevel logLevel)
+YDLidarX4StateMachine::YDLidarX4StateMachine(LidarQueue<uint8_t> &queue, OnLidarPacketHandler *packetHandler, OnLidarIndexPacketHandler *indexPacketHandler, Print *debug, Print *trace, LogLevel logLevel)
   : queue(queue),
   packetHandler(packetHandler),
   indexPacketHandler(indexPacketHandler),
+  fixedPointPacketHandler(nullptr),
+  packetCallback(nullptr),
+  packetCallbackContext(nullptr),
+  fixedPointPacketCallback(nullptr),
+  fixedPointPacketCallbackContext(nullptr),
+  timedPacketHandler(nullptr),
+  frameHandler(nullptr),
+  frameAssembler(nullptr),
+  clusterExtractor(nullptr),
+  polarGrid(nullptr),
+  nearestObstacleTracker(nullptr),
+  occupancyGrid(nullptr),
+  angularRoi(nullptr),
+  rangeFilter(nullptr),
+  decimator(nullptr),
+  pointCloudHandler(nullptr),
+  floatPointCloudHandler(nullptr),
+  healthStatusHandler(nullptr),
+  deviceInfoHandler(nullptr),
   debug(debug),
   trace(trace),
   logLevel(logLevel),
-  state(IDLE)
+  decodedPaketCount(0),
+  revolutionCount(0),
+  isAngleCorrectionFallback(false),
+  receiveTimestamps(nullptr),
+  samplesInRevolution(0),
+  resyncOnError(false),
+  resyncCount(0),
+  resyncDiscardedBytes(0),
+  state(IDLE),
+  scratch(new PaketScratch)
 {
 }
 
@@ -56,6 +87,18 @@ bool YDLidarX4StateMachine::runOne(){
   return state != oldState;
 }
 
+// runs the states in a tight loop until the state machine has to wait for more data
+// (or hits an error/timeout/end) and returns the count of pakets decoded on the way
+size_t YDLidarX4StateMachine::runBatch(){
+  unsigned long decodedPaketCountBefore = decodedPaketCount;
+  State oldState;
+  do{
+    oldState = state;
+    state = handleState();
+  }while(state != oldState);
+  return decodedPaketCount - decodedPaketCountBefore;
+}
+
 void YDLidarX4StateMachine::setStateIdle(){
   setState(IDLE);
 }
@@ -96,13 +139,129 @@ bool YDLidarX4StateMachine::isScanning(){
     state == SCAN_NEED_SIZE ||
     state == SCAN_NEED_DATA ||
     state == SCAN_CHECK_CRC ||
-    state == SCAN_SEND_MESSAGE;
+    state == SCAN_SEND_MESSAGE ||
+    state == SCAN_RESYNC ||
+    state == SCAN_NEED_RESPONSE_DATA;
 }
 
 string YDLidarX4StateMachine::getState(){
   return getState(state);
 }
 
+unsigned long YDLidarX4StateMachine::getDecodedPaketCount(){
+  return decodedPaketCount;
+}
+
+// counts the index pakets, wraps around at 65536
+uint16_t YDLidarX4StateMachine::getRevolutionCount(){
+  return revolutionCount;
+}
+
+float YDLidarX4StateMachine::getScanFrequencyInHz(){
+  return scanRate.getFrequencyInHz();
+}
+
+float YDLidarX4StateMachine::getScanPeriodJitterInMicros(){
+  return scanRate.getJitterInMicros();
+}
+
+unsigned long YDLidarX4StateMachine::getLastIndexPacketTimeInMicros(){
+  return scanRate.getLastIndexTimeInMicros();
+}
+
+void YDLidarX4StateMachine::setResyncOnError(bool resyncOnError){
+  this->resyncOnError = resyncOnError;
+}
+
+// falls back to the interpolated table if the full table does not fit into the heap
+void YDLidarX4StateMachine::setAngleCorrectionMode(AngleCorrectionMode angleCorrectionMode){
+  isAngleCorrectionFallback = !angleCorrection.setMode(angleCorrectionMode);
+  if(isAngleCorrectionFallback){
+    angleCorrection.setMode(ANGLE_CORRECTION_INTERPOLATED);
+  }
+}
+
+bool YDLidarX4StateMachine::hasAngleCorrectionFallback(){
+  return isAngleCorrectionFallback;
+}
+
+void YDLidarX4StateMachine::setFixedPointPacketHandler(OnLidarFixedPointPacketHandler *fixedPointPacketHandler){
+  this->fixedPointPacketHandler = fixedPointPacketHandler;
+}
+
+void YDLidarX4StateMachine::setPacketCallback(LidarPacketCallback packetCallback, void *context){
+  this->packetCallback = packetCallback;
+  this->packetCallbackContext = context;
+}
+
+void YDLidarX4StateMachine::setFixedPointPacketCallback(LidarFixedPointPacketCallback fixedPointPacketCallback, void *context){
+  this->fixedPointPacketCallback = fixedPointPacketCallback;
+  this->fixedPointPacketCallbackContext = context;
+}
+
+void YDLidarX4StateMachine::setTimedPacketHandler(OnLidarTimedPacketHandler *timedPacketHandler){
+  this->timedPacketHandler = timedPacketHandler;
+}
+
+void YDLidarX4StateMachine::setReceiveTimestamps(ReceiveTimestamps *receiveTimestamps){
+  this->receiveTimestamps = receiveTimestamps;
+}
+
+void YDLidarX4StateMachine::setFrameHandler(FrameAssembler *frameAssembler, OnLidarFrameHandler *frameHandler){
+  this->frameAssembler = frameAssembler;
+  this->frameHandler = frameHandler;
+}
+
+void YDLidarX4StateMachine::setClusterExtractor(ClusterExtractor *clusterExtractor){
+  this->clusterExtractor = clusterExtractor;
+}
+
+void YDLidarX4StateMachine::setPolarGrid(PolarGrid *polarGrid){
+  this->polarGrid = polarGrid;
+}
+
+void YDLidarX4StateMachine::setNearestObstacleTracker(NearestObstacleTracker *nearestObstacleTracker){
+  this->nearestObstacleTracker = nearestObstacleTracker;
+}
+
+void YDLidarX4StateMachine::setOccupancyGrid(OccupancyGrid *occupancyGrid){
+  this->occupancyGrid = occupancyGrid;
+}
+
+void YDLidarX4StateMachine::setPointCloudHandlers(OnLidarPointCloudHandler *pointCloudHandler, OnLidarFloatPointCloudHandler *floatPointCloudHandler){
+  this->pointCloudHandler = pointCloudHandler;
+  this->floatPointCloudHandler = floatPointCloudHandler;
+}
+
+void YDLidarX4StateMachine::setMountingOffset(int16_t offsetXInMillimeter, int16_t offsetYInMillimeter, float rotationInDegree){
+  cartesianConverter.setMountingOffset(offsetXInMillimeter, offsetYInMillimeter, rotationInDegree);
+}
+
+void YDLidarX4StateMachine::setAngularRoi(AngularRoi *angularRoi){
+  this->angularRoi = angularRoi;
+}
+
+void YDLidarX4StateMachine::setDecimator(Decimator *decimator){
+  this->decimator = decimator;
+}
+
+void YDLidarX4StateMachine::setRangeFilter(RangeFilter *rangeFilter){
+  this->rangeFilter = rangeFilter;
+}
+
+void YDLidarX4StateMachine::setResponseHandlers(OnLidarHealthStatusHandler *healthStatusHandler, OnLidarDeviceInfoHandler *deviceInfoHandler){
+  this->healthStatusHandler = healthStatusHandler;
+  this->deviceInfoHandler = deviceInfoHandler;
+}
+
+unsigned long YDLidarX4StateMachine::getResyncCount(){
+  return resyncCount;
+}
+
+unsigned long YDLidarX4StateMachine::getResyncDiscardedBytes(){
+  return resyncDiscardedBytes;
+}
+
 string YDLidarX4StateMachine::getState(State lidarState){
   switch (lidarState){
     case IDLE:                  return "Idle";
@@ -116,6 +275,8 @@ string YDLidarX4StateMachine::getState(State lidarState){
     case SCAN_NEED_DATA:        return "ScanNeedData";
     case SCAN_CHECK_CRC:        return "ScanCheckCrc";
     case SCAN_SEND_MESSAGE:     return "ScanSendMessages";
+    case SCAN_RESYNC:           return "ScanResync";
+    case SCAN_NEED_RESPONSE_DATA: return "ScanNeedResponseData";
     case STOP:                  return "Stop";
     case TIMEOUT:               return "Timeout";
     case END:                   return "End";
@@ -136,6 +297,8 @@ YDLidarX4StateMachine::State YDLidarX4StateMachine::handleState(){
     case SCAN_NEED_DATA:        return handleStateScanNeedData();
     case SCAN_CHECK_CRC:        return handleStateScanCheckCrc();
     case SCAN_SEND_MESSAGE:     return handleStateScanSendMessages();
+    case SCAN_RESYNC:           return handleStateScanResync();
+    case SCAN_NEED_RESPONSE_DATA: return handleStateScanNeedResponseData();
     case STOP:                  return handleStateStop();
     case TIMEOUT:               return handleStateTimeout();
     case END:                   return END;
@@ -144,7 +307,21 @@ YDLidarX4StateMachine::State YDLidarX4StateMachine::handleState(){
 }
 
 YDLidarX4StateMachine::State YDLidarX4StateMachine::handleStateIdle(){
-  queue.clear();
+  clearQueue();
+  if(frameAssembler != nullptr){
+    frameAssembler->reset();
+  }
+  scanRate.reset();
+  samplesInRevolution = 0;
+  if(rangeFilter != nullptr){
+    rangeFilter->reset();
+  }
+  if(decimator != nullptr){
+    decimator->reset();
+  }
+  if(clusterExtractor != nullptr){
+    clusterExtractor->reset();
+  }
   return READY;
 }
 
@@ -156,11 +333,13 @@ YDLidarX4StateMachine::State YDLidarX4StateMachine::handleStateReady(){
 }
 
 YDLidarX4StateMachine::State YDLidarX4StateMachine::handleStateStart(){
-  if(queue.get(0) != 0xA5){
+  uint8_t header[2];
+  size_t headerSize = queue.peek(0, header, sizeof(header));
+  if(header[0] != 0xA5){
     IF_DEBUG debug->printf("   ### handleStateStart: first byte did not match\n");
 
-    if(queue.get(0) == 0xAA){
-      if(queue.size()>1 && queue.get(1) == 0x55){
+    if(header[0] == 0xAA){
+      if(headerSize>1 && header[1] == 0x55){
         // sometimes the header is missing !!! :O -> short cut | TODO or only with testdata?
         IF_DEBUG debug->printf("   ### handleStateStart: found packet without header -> goto START_NEED_MORE_DATA\n");
         return SCAN_NEED_SIZE;
@@ -188,14 +367,11 @@ YDLidarX4StateMachine::State YDLidarX4StateMachine::handleStateStartCheckPaket()
 }
 
 bool YDLidarX4StateMachine::isCorrectStartPaket(){
-  for(int bytePosition=0; bytePosition<startHeaderSize; bytePosition++){
-    uint8_t actual = queue.get(bytePosition);
-    uint8_t expected = expecedLidarStartResponse[bytePosition];
-    if (actual != expected){
-      return false;
-    }
+  uint8_t actual[startHeaderSize];
+  if(queue.peek(0, actual, startHeaderSize) < startHeaderSize){
+    return false;
   }
-  return true;
+  return memcmp(actual, expecedLidarStartResponse, startHeaderSize) == 0;
 }
 
 YDLidarX4StateMachine::State YDLidarX4StateMachine::handleStateStartRemovePaket(){
@@ -210,64 +386,141 @@ bool YDLidarX4StateMachine::removeBytesFromQueue(uint16_t byteCountToRemove){
   if(queue.size() < byteCountToRemove){
     return false;
   }
-  queue.remove(byteCountToRemove);
+  removeFromQueue(byteCountToRemove);
   return true;
 }
 
+// every removal goes through here, so the receive timestamps stay in line with the queue
+void YDLidarX4StateMachine::removeFromQueue(size_t size){
+  queue.remove(size);
+  if(receiveTimestamps != nullptr){
+    receiveTimestamps->consume(size);
+  }
+}
+
+void YDLidarX4StateMachine::clearQueue(){
+  queue.clear();
+  if(receiveTimestamps != nullptr){
+    receiveTimestamps->clear();
+  }
+}
+
 YDLidarX4StateMachine::State YDLidarX4StateMachine::handleStateScanNeedHeader(){
-  if(queue.size() <= packetHeaderMsb){
+  // one look into the queue for all header bytes (a response header is the longest)
+  uint8_t header[responseHeaderSize];
+  size_t headerSize = queue.peek(0, header, responseHeaderSize);
+  if(headerSize <= packetHeaderMsb){
     return SCAN_NEED_HEADER;
   }
-  if(queue.get(0) != 0xAA){
+  if(header[0] != 0xAA){
     IF_DEBUG debug->printf("   ### paket start not 0xAA\n");
     // debugPrintQueue("(something wrong)");
 
-    if(queue.get(0) == 0xA5){
-      IF_DEBUG debug->printf("   ### paket start with 0xA5 -> todo, impl this\n");
-      if(queue.get(1) == 0x5A){
-        IF_DEBUG debug->printf("   ### paket start with 0xA5 0x5A -> todo, impl this\n");
-        if(queue.get(6)==0x06){
-          debugPrintQueue("(possible HEALF STATUS)");
-        }else if(queue.get(6)==0x04){
-          debugPrintQueue("(possible DEVICE INFORMATION)");
-        }else{
-          debugPrintQueue("(unknown)");
+    if(header[0] == 0xA5){
+      if(header[1] == 0x5A){
+        // response to a command (health status, device info) in the scan stream
+        if(headerSize < responseHeaderSize){
+          return SCAN_NEED_HEADER;
         }
-        int lenToRemove = queue.get(2)+7;
-        debug->printf(" --- remove %d bytes from buffer\n",lenToRemove);
-        // todo do we have enought bytes in the buffer to delete them?
-        queue.remove(lenToRemove); // TODO this is a workaround - extract it to its own state
-        return SCAN_NEED_HEADER;
+        uint32_t payloadSize = getResponsePayloadSize(header);
+        if(payloadSize > maxResponsePayloadSize){
+          IF_DEBUG debug->printf("   ### response too long: %lu bytes\n", (unsigned long)payloadSize);
+          return resyncOrError();
+        }
+        expectedResponseSize = responseHeaderSize + payloadSize;
+        return SCAN_NEED_RESPONSE_DATA;
       }
-    }else if(queue.get(0) == 0x00){
+    }else if(header[0] == 0x00){
       debugPrintQueue("(zeros ?)");
       int i;
-      for(i=0;queue.get(0)== 0x00;i++){
-        queue.remove(1);
+      for(i=0;queue.size()>0 && queue.get(0)== 0x00;i++){
+        removeFromQueue(1);
       }
       IF_DEBUG debug->printf("   ### removed %d 0x00 byte\n", i);
       return SCAN_NEED_HEADER;
     }
 
-    return ERROR;
+    return resyncOrError();
   }
-  if(queue.get(1) != 0x55){
+  if(header[1] != 0x55){
     IF_DEBUG debug->printf("   ### paket start not 0xAA 0x55\n");
-    return ERROR;
+    return resyncOrError();
   }
   return SCAN_NEED_SIZE;
 }
 
+// response length: 30 bits little endian, the upper 2 bits are the response mode
+uint32_t YDLidarX4StateMachine::getResponsePayloadSize(uint8_t *header){
+  return header[responseLength]
+    | (header[responseLength+1] << 8)
+    | (header[responseLength+2] << 16)
+    | ((uint32_t)(header[responseLength+3] & 0x3F) << 24);
+}
+
+YDLidarX4StateMachine::State YDLidarX4StateMachine::handleStateScanNeedResponseData(){
+  uint8_t response[responseHeaderSize + maxResponsePayloadSize];
+  if(queue.peek(0, response, expectedResponseSize) < expectedResponseSize){
+    return SCAN_NEED_RESPONSE_DATA;
+  }
+  handleResponse(response[responseType], &response[responsePayloadPos], expectedResponseSize - responseHeaderSize);
+  removeFromQueue(expectedResponseSize);
+  return SCAN_NEED_HEADER;
+}
+
+void YDLidarX4StateMachine::handleResponse(uint8_t type, uint8_t *payload, size_t payloadSize){
+  if(type == healthStatusResponse && payloadSize >= healthStatusPayloadSize){
+    handleHealthStatusResponse(payload);
+  }else if(type == deviceInfoResponse && payloadSize >= deviceInfoPayloadSize){
+    handleDeviceInfoResponse(payload);
+  }else{
+    IF_DEBUG debug->printf("   ### skip response type 0x%s with %lu bytes\n", hex(type).c_str(), (unsigned long)payloadSize);
+  }
+}
+
+void YDLidarX4StateMachine::handleHealthStatusResponse(uint8_t *payload){
+  LidarHealthStatus healthStatus;
+  healthStatus.status = payload[0];
+  healthStatus.errorCode = payload[1] | (payload[2] << 8);
+  IF_DEBUG debug->printf("   health status: %u error code: 0x%s\n", healthStatus.status, hex(healthStatus.errorCode).c_str());
+
+  if(healthStatusHandler != nullptr){
+    healthStatusHandler->operator()(healthStatus);
+  }
+}
+
+void YDLidarX4StateMachine::handleDeviceInfoResponse(uint8_t *payload){
+  LidarDeviceInfo deviceInfo;
+  deviceInfo.model = payload[0];
+  deviceInfo.firmwareMinor = payload[1];
+  deviceInfo.firmwareMajor = payload[2];
+  deviceInfo.hardware = payload[3];
+  memcpy(deviceInfo.serialNumber, &payload[4], sizeof(deviceInfo.serialNumber));
+  IF_DEBUG debug->printf("   device info: model %u firmware %u.%u hardware %u\n", deviceInfo.model, deviceInfo.firmwareMajor, deviceInfo.firmwareMinor, deviceInfo.hardware);
+
+  if(deviceInfoHandler != nullptr){
+    deviceInfoHandler->operator()(deviceInfo);
+  }
+}
+
 YDLidarX4StateMachine::State YDLidarX4StateMachine::handleStateScanNeedSize(){
-  if(queue.size() <= packetSampleQuantity){
+  uint8_t header[packetSampleQuantity+1];
+  if(queue.peek(0, header, sizeof(header)) < sizeof(header)){
     return SCAN_NEED_SIZE;
   }
-  expectedPaketSize = getScanPaketExpectedSize();
+  expectedPaketSize = getScanPaketExpectedSize(header[packetSampleQuantity]);
+  if(expectedPaketSize > queue.getCapacity()){
+    // a false 0xAA 0x55 in the data, waiting for the paket would only fill the queue
+    IF_DEBUG debug->printf("   ### paket of %lu bytes does not fit into the queue\n", (unsigned long)expectedPaketSize);
+    if(resyncOnError){
+      removeFromQueue(1);
+      resyncDiscardedBytes++;
+    }
+    return resyncOrError();
+  }
   return SCAN_NEED_DATA;
 }
 
-uint16_t YDLidarX4StateMachine::getScanPaketExpectedSize(){
-  uint8_t paketSize = queue.get(packetSampleQuantity);
+uint16_t YDLidarX4StateMachine::getScanPaketExpectedSize(uint8_t paketSize){
   uint16_t expectedPaketSize = sampleBeginPos + 2 * paketSize;
   return expectedPaketSize;
 }
@@ -280,39 +533,34 @@ YDLidarX4StateMachine::State YDLidarX4StateMachine::handleStateScanNeedData(){
 }
 
 YDLidarX4StateMachine::State YDLidarX4StateMachine::handleStateScanCheckCrc(){
-  queue.extract(paket.rawData, expectedPaketSize);
+  if(!queue.view(expectedPaketSize, paket)){
+    IF_DEBUG debug->printf("   ### could not view pkg in queue\n");
+    return ERROR;
+  }
   if(!isCorrectCrc()){
     IF_DEBUG debug->printf("   ### wrong crc on pkg\n");
-    return ERROR;
+    if(resyncOnError){
+      // the header looked valid - drop its first byte, so the search does not find it again
+      removeFromQueue(1);
+      resyncDiscardedBytes++;
+    }
+    return resyncOrError();
   }
   return SCAN_SEND_MESSAGE;
 }
 
 bool YDLidarX4StateMachine::isCorrectCrc(){
-  uint16_t ph = paket.header;
-  uint8_t type =  paket.type;
-  uint8_t sampleQuantity = paket.quantity;
-  uint16_t startAngle = paket.startAngle;
-  uint16_t lastAngle = paket.lastAngle;
-  uint16_t cs =  paket.checkSum;
-
-  uint16_t ct_lsn = 256 * sampleQuantity + type;
+  uint16_t cs = paketWord(checkSumLsb);
 
-  uint16_t crc = 0;
-  crc ^= ph;
-  crc ^= ct_lsn;
-  crc ^= startAngle;
-  crc ^= lastAngle;
-  for(uint16_t sampleId=0; sampleId<(uint16_t)sampleQuantity; sampleId++){
-    uint16_t distance = paket.samples[sampleId];
-    crc ^= distance;
-  }
+  // the checksum is the XOR of all other words of the paket,
+  // so XORing the whole paket (checksum included) and the checksum again gives the calculated one
+  uint16_t crc = paketChecksum() ^ cs;
 
   if(cs != crc){
     uint16_t diff_crc = cs^crc;
     IF_DEBUG debug->printf("crc_error --> crc_calc(%s) crc_pkg(%s) diff(%s)\n", hex(crc).c_str(), hex(cs).c_str(), hex(diff_crc).c_str());
-    for(int i=0; i<(sampleBeginPos+sizeof(uint16_t)*256); i++){
-      IF_DEBUG debug->printf("0x%s ",hex(paket.rawData[i]).c_str());
+    for(size_t i=0; i<paket.size(); i++){
+      IF_DEBUG debug->printf("0x%s ",hex(paket[i]).c_str());
     }
     IF_DEBUG debug->println();
   }
@@ -321,35 +569,242 @@ bool YDLidarX4StateMachine::isCorrectCrc(){
 
 YDLidarX4StateMachine::State YDLidarX4StateMachine::handleStateScanSendMessages(){
   handleValidPacket();
+  decodedPaketCount++;
+  // release the paket bytes not until the paket is handled - the view points into the queue
+  removeFromQueue(expectedPaketSize);
   return SCAN_NEED_HEADER;
 }
 
 void YDLidarX4StateMachine::handleValidPacket(){
-  uint8_t type =  paket.type;
-  uint8_t sampleQuantity = paket.quantity;
-  uint16_t startAngle = paket.startAngle;
-  uint16_t lastAngle = paket.lastAngle;
+  uint8_t type = paketByte(packetType);
+  uint8_t sampleQuantity = paketByte(packetSampleQuantity);
+  uint16_t startAngle = paketWord(startAngleLsb);
+  uint16_t lastAngle = paketWord(lastAngleLsb);
 
+  bool isIndexPaket = type==indexPacket;
+  if(isIndexPaket){
+    revolutionCount++;
+  }
+  LidarPacketTime time = calculatePaketTime(isIndexPaket, sampleQuantity);
+  bool isDecimating = decimator != nullptr && decimator->isEnabled();
+  if(isIndexPaket && isDecimating){
+    flushDecimator(time);
+  }
+
+  // select the samples inside the angular ROI before anything is decoded
+  uint8_t paketSampleQuantity = sampleQuantity;
+  uint8_t firstSample = 0;
+  if(angularRoi != nullptr && !angularRoi->select(angleInQ6Degree(startAngle), angleInQ6Degree(lastAngle), paketSampleQuantity, firstSample, sampleQuantity)){
+    // the index packet still ends the revolution
+    handleFrame(isIndexPaket, time, nullptr, nullptr, 0);
+    return;
+  }
+  time.firstSampleTimeInMicros = time.sampleTimeInMicros(firstSample);
+
+  // the raw distances are the fixed point ranges in 0.25mm
+  uint16_t *rangesInQuarterMillimeter = scratch->distances;
+  for(uint16_t sampleNum=0; sampleNum<(uint16_t)sampleQuantity; sampleNum++){
+    rangesInQuarterMillimeter[sampleNum] = paketSample(firstSample + sampleNum);
+  }
+
+  uint16_t startAngleInQ6Degree = angleInQ6Degree(startAngle);
+  uint16_t stopAngleInQ6Degree = angleInQ6Degree(lastAngle);
+
+  // the decimation works on the raw samples, so the dropped ones are never converted
+  if(isDecimating){
+    size_t lenght = decimatePaket(paketSampleQuantity, startAngleInQ6Degree, stopAngleInQ6Degree, firstSample, sampleQuantity, rangesInQuarterMillimeter);
+    if(lenght == 0){
+      handleFrame(isIndexPaket, time, nullptr, nullptr, 0);
+      return;
+    }
+    // the kept samples are spread over the time of the selected ones
+    if(lenght > 1){
+      time.samplePeriodInMicros = time.samplePeriodInMicros * (sampleQuantity-1) / (lenght-1);
+    }
+    handleDecimatedSamples(isIndexPaket, time, lenght);
+    return;
+  }
+
+  if(hasFixedPointOutput()){
+    uint16_t *correctedAnglesInQ6Degree = scratch->anglesInQ6Degree;
+    uint16_t minAngleInQ6Degree = startAngleInQ6Degree;
+    uint16_t maxAngleInQ6Degree = stopAngleInQ6Degree;
+    calculateFixedPointAnglesFromPaket(paketSampleQuantity, startAngleInQ6Degree, stopAngleInQ6Degree, firstSample, sampleQuantity, rangesInQuarterMillimeter, correctedAnglesInQ6Degree);
+    if(sampleQuantity < paketSampleQuantity){
+      minAngleInQ6Degree = interpolatedAngleInQ6Degree(startAngleInQ6Degree, stopAngleInQ6Degree, paketSampleQuantity, firstSample);
+      maxAngleInQ6Degree = interpolatedAngleInQ6Degree(startAngleInQ6Degree, stopAngleInQ6Degree, paketSampleQuantity, firstSample + sampleQuantity - 1);
+    }
+    notifyFixedPointOutputs(minAngleInQ6Degree, maxAngleInQ6Degree, correctedAnglesInQ6Degree, rangesInQuarterMillimeter, sampleQuantity);
+  }
+
+  if(!hasFloatOutput()){
+    return;
+  }
   float startAngleInDegree = angleInDegree(startAngle);
   float stopAngleInDegree = angleInDegree(lastAngle);
-  bool isIndexPaket = type==indexPacket;
+  if(sampleQuantity < paketSampleQuantity){
+    float paketStartAngleInDegree = startAngleInDegree;
+    startAngleInDegree = interpolatedAngleInDegree(paketStartAngleInDegree, stopAngleInDegree, paketSampleQuantity, firstSample);
+    stopAngleInDegree = interpolatedAngleInDegree(paketStartAngleInDegree, stopAngleInDegree, paketSampleQuantity, firstSample + sampleQuantity - 1);
+  }
+  float *rangesInMillimeter = scratch->rangesInMillimeter;
+  float *correctedAnglesInDegree = scratch->anglesInDegree;
+  calculateRangesAndAnglesFromPaket(sampleQuantity, startAngleInDegree, stopAngleInDegree, rangesInQuarterMillimeter, rangesInMillimeter, correctedAnglesInDegree);
+  notifyFloatOutputs(isIndexPaket, time, startAngleInDegree, stopAngleInDegree, correctedAnglesInDegree, rangesInMillimeter, sampleQuantity);
+}
+
+// uncorrected angles of the selected samples in 1/65536 degree [0, 360), reduced by the decimator
+size_t YDLidarX4StateMachine::decimatePaket(uint8_t paketSampleQuantity, uint16_t startAngleInQ6Degree, uint16_t stopAngleInQ6Degree, uint8_t firstSample, uint8_t sampleQuantity, const uint16_t* distances){
+  const int32_t fullCircleInQ16Degree = 360 << 16;
+  int32_t *anglesInQ16Degree = scratch->anglesInQ16Degree;
+  int32_t stepInQ16Degree = fixedPointStepInQ16Degree(startAngleInQ6Degree, stopAngleInQ6Degree, paketSampleQuantity);
+  int32_t angleInQ16Degree = ((int32_t)startAngleInQ6Degree << 10) + firstSample * stepInQ16Degree;
+  for(uint16_t sampleNum=0; sampleNum<(uint16_t)sampleQuantity; sampleNum++){
+    anglesInQ16Degree[sampleNum] = angleInQ16Degree < fullCircleInQ16Degree ? angleInQ16Degree : angleInQ16Degree - fullCircleInQ16Degree;
+    angleInQ16Degree += stepInQ16Degree;
+  }
+  return decimator->decimate(anglesInQ16Degree, distances, sampleQuantity, scratch->decimatedAnglesInQ16Degree, scratch->decimatedDistances);
+}
+
+// the last sector of a revolution is only finished by the first sample of the next one,
+// so its pending sample is delivered before the index paket starts the new revolution
+void YDLidarX4StateMachine::flushDecimator(const LidarPacketTime &indexPaketTime){
+  size_t lenght = decimator->flush(scratch->decimatedAnglesInQ16Degree, scratch->decimatedDistances);
+  if(lenght == 0){
+    return;
+  }
+  // at least one sample period before the index paket
+  LidarPacketTime time = indexPaketTime;
+  time.firstSampleTimeInMicros -= (unsigned long)time.samplePeriodInMicros;
+  handleDecimatedSamples(false, time, lenght);
+}
+
+// the decimated samples are in the scratch buffers
+void YDLidarX4StateMachine::handleDecimatedSamples(bool isIndexPaket, const LidarPacketTime &time, size_t lenght){
+  const int32_t *decimatedAnglesInQ16Degree = scratch->decimatedAnglesInQ16Degree;
+  uint16_t *rangesInQuarterMillimeter = scratch->decimatedDistances;
+
+  if(hasFixedPointOutput()){
+    uint16_t *correctedAnglesInQ6Degree = scratch->anglesInQ6Degree;
+    calculateFixedPointAnglesFromSamples(lenght, decimatedAnglesInQ16Degree, rangesInQuarterMillimeter, correctedAnglesInQ6Degree);
+    uint16_t minAngleInQ6Degree = ((decimatedAnglesInQ16Degree[0] + 512) >> 10) % (360*64);
+    uint16_t maxAngleInQ6Degree = ((decimatedAnglesInQ16Degree[lenght-1] + 512) >> 10) % (360*64);
+    notifyFixedPointOutputs(minAngleInQ6Degree, maxAngleInQ6Degree, correctedAnglesInQ6Degree, rangesInQuarterMillimeter, lenght);
+  }
+
+  if(!hasFloatOutput()){
+    return;
+  }
+  float *rangesInMillimeter = scratch->rangesInMillimeter;
+  float *correctedAnglesInDegree = scratch->anglesInDegree;
+  calculateRangesAndAnglesFromSamples(lenght, decimatedAnglesInQ16Degree, rangesInQuarterMillimeter, rangesInMillimeter, correctedAnglesInDegree);
+  float startAngleInDegree = decimatedAnglesInQ16Degree[0] * (1.0f/65536);
+  float stopAngleInDegree = decimatedAnglesInQ16Degree[lenght-1] * (1.0f/65536);
+  notifyFloatOutputs(isIndexPaket, time, startAngleInDegree, stopAngleInDegree, correctedAnglesInDegree, rangesInMillimeter, lenght);
+}
+
+void YDLidarX4StateMachine::notifyFixedPointOutputs(uint16_t minAngleInQ6Degree, uint16_t maxAngleInQ6Degree, uint16_t correctedAnglesInQ6Degree[], uint16_t rangesInQuarterMillimeter[], size_t lenght){
+  notifyFixedPointPacketHandler(minAngleInQ6Degree, maxAngleInQ6Degree, correctedAnglesInQ6Degree, rangesInQuarterMillimeter, lenght);
+  if(polarGrid != nullptr){
+    polarGrid->update(correctedAnglesInQ6Degree, rangesInQuarterMillimeter, lenght, revolutionCount);
+  }
+  if(nearestObstacleTracker != nullptr){
+    nearestObstacleTracker->update(correctedAnglesInQ6Degree, rangesInQuarterMillimeter, lenght);
+  }
+  if(occupancyGrid != nullptr){
+    occupancyGrid->update(correctedAnglesInQ6Degree, rangesInQuarterMillimeter, lenght);
+  }
+  notifyPointCloudHandlers(correctedAnglesInQ6Degree, rangesInQuarterMillimeter, lenght);
+}
+
+void YDLidarX4StateMachine::notifyFloatOutputs(bool isIndexPaket, const LidarPacketTime &time, float minAngleInDegree, float maxAngleInDegree, float correctedAnglesInDegree[], float rangesInMillimeter[], size_t lenght){
+  if(rangeFilter != nullptr && !rangeFilter->filter(correctedAnglesInDegree, rangesInMillimeter, lenght)){
+    IF_DEBUG debug->printf("range filter skipped a paket of %lu samples\n", lenght);
+  }
+  printRangesAndAnglesFromPaket(isIndexPaket, lenght, minAngleInDegree, maxAngleInDegree, correctedAnglesInDegree, rangesInMillimeter);
+  notifyHandlers(isIndexPaket, minAngleInDegree, maxAngleInDegree, correctedAnglesInDegree, rangesInMillimeter, lenght);
+  if(timedPacketHandler != nullptr){
+    timedPacketHandler->operator()(time, correctedAnglesInDegree, rangesInMillimeter, lenght);
+  }
+  handleFrame(isIndexPaket, time, correctedAnglesInDegree, rangesInMillimeter, lenght);
+}
+
+// the paket is sent after its last sample was measured, the samples before are one sample period apart
+LidarPacketTime YDLidarX4StateMachine::calculatePaketTime(bool isIndexPaket, uint8_t sampleQuantity){
+  unsigned long now = micros();
+  unsigned long receiveTime = receiveTimestamps != nullptr ? receiveTimestamps->getTimeInMicros(expectedPaketSize-1, now) : now;
+  if(isIndexPaket){
+    scanRate.handleIndex(receiveTime, samplesInRevolution);
+    samplesInRevolution = 0;
+  }
+  samplesInRevolution += sampleQuantity;
+
+  LidarPacketTime time;
+  time.receiveTimeInMicros = receiveTime;
+  time.samplePeriodInMicros = scanRate.getSamplePeriodInMicros();
+  unsigned long lastSampleTime = receiveTime - expectedPaketSize * byteTimeInNanos / 1000;
+  // a paket without samples has no first sample, its time is the paket end
+  time.firstSampleTimeInMicros = sampleQuantity == 0 ? lastSampleTime : lastSampleTime - (unsigned long)((sampleQuantity-1) * time.samplePeriodInMicros);
+  return time;
+}
+
+bool YDLidarX4StateMachine::hasFixedPointOutput(){
+  return fixedPointPacketHandler != nullptr || fixedPointPacketCallback != nullptr || polarGrid != nullptr || nearestObstacleTracker != nullptr || occupancyGrid != nullptr || pointCloudHandler != nullptr || floatPointCloudHandler != nullptr;
+}
 
-  float rangesInMillimeter[sampleQuantity];
-  float correctedAnglesInDegree[sampleQuantity];
-  calculateRangesAndAnglesFromPaket(paket, sampleQuantity, startAngleInDegree, stopAngleInDegree, rangesInMillimeter, correctedAnglesInDegree);
-  printRangesAndAnglesFromPaket(isIndexPaket, sampleQuantity, startAngleInDegree, stopAngleInDegree, correctedAnglesInDegree, rangesInMillimeter);
-  notifyHandlers(isIndexPaket, startAngleInDegree, stopAngleInDegree, correctedAnglesInDegree, rangesInMillimeter, sampleQuantity);
+bool YDLidarX4StateMachine::hasFloatOutput(){
+  bool isTracing = trace != &DummyPrint && logLevel == LOG_TRACE;
+  return packetHandler != nullptr || indexPacketHandler != nullptr || packetCallback != nullptr || timedPacketHandler != nullptr || frameAssembler != nullptr || clusterExtractor != nullptr || isTracing;
 }
 
 // tested: 0x6fe5 | fsa 223.78=223.781 | cfsa -6.7622=-6.76219 | 217.0178 degree = 217.019
 // tested: 0x79bd | lsa 243.47=243.469 | lfsa -7.8374=-7.83743 | 235.6326 degree = 235.631
-void YDLidarX4StateMachine::calculateRangesAndAnglesFromPaket(Paket &paket, uint8_t sampleQuantity, float startAngleInDegree, float stopAngleInDegree, float* rangesInMillimeter, float* correctedAnglesInDegree){
+void YDLidarX4StateMachine::calculateRangesAndAnglesFromPaket(uint8_t sampleQuantity, float startAngleInDegree, float stopAngleInDegree, const uint16_t* distances, float* rangesInMillimeter, float* correctedAnglesInDegree){
+  distancesInMillimeter(distances, sampleQuantity, rangesInMillimeter);
+  interpolateAnglesInDegree(startAngleInDegree, stopAngleInDegree, sampleQuantity, correctedAnglesInDegree);
+  // the correction is a lookup (or atan) per sample and stays scalar
   for(uint16_t sampleNum=0; sampleNum<(uint16_t)sampleQuantity; sampleNum++){
-    uint16_t distanceBytes_i = paket.samples[sampleNum];
+    correctedAnglesInDegree[sampleNum] = wrapAngleInDegree(correctedAnglesInDegree[sampleNum] + angleCorrection.inDegree(distances[sampleNum]));
+  }
+}
+
+// integer only: the angles are interpolated in 1/65536 degree (handles the 360->0 wrap)
+// and corrected with the fixed point table, the result is rounded to 1/64 degree
+void YDLidarX4StateMachine::calculateFixedPointAnglesFromPaket(uint8_t paketSampleQuantity, uint16_t startAngleInQ6Degree, uint16_t stopAngleInQ6Degree, uint8_t firstSample, uint8_t sampleQuantity, const uint16_t* distances, uint16_t* correctedAnglesInQ6Degree){
+  const int32_t fullCircleInQ6Degree = 360*64;
+  int32_t stepInQ16Degree = fixedPointStepInQ16Degree(startAngleInQ6Degree, stopAngleInQ6Degree, paketSampleQuantity);
+  int32_t angleInQ16Degree = ((int32_t)startAngleInQ6Degree << 10) + firstSample * stepInQ16Degree;
+
+  for(uint16_t sampleNum=0; sampleNum<(uint16_t)sampleQuantity; sampleNum++){
+    int32_t correctedAngleInQ6Degree = (angleInQ16Degree + angleCorrection.inFixedPoint(distances[sampleNum]) + 512) >> 10;
+    if(correctedAngleInQ6Degree < 0){
+      correctedAngleInQ6Degree += fullCircleInQ6Degree;
+    }else if(correctedAngleInQ6Degree >= fullCircleInQ6Degree){
+      correctedAngleInQ6Degree -= fullCircleInQ6Degree;
+    }
+    correctedAnglesInQ6Degree[sampleNum] = correctedAngleInQ6Degree;
+    angleInQ16Degree += stepInQ16Degree;
+  }
+}
 
-    float distanceInMillimeterValue_i = distanceInMillimeter(distanceBytes_i);
-    rangesInMillimeter[sampleNum] = distanceInMillimeterValue_i;
-    correctedAnglesInDegree[sampleNum] = calculateAngleInDegree(distanceInMillimeterValue_i, startAngleInDegree, stopAngleInDegree, sampleNum, sampleQuantity);
+// the decimated samples are no longer equidistant, every sample brings its own angle
+void YDLidarX4StateMachine::calculateRangesAndAnglesFromSamples(size_t lenght, const int32_t* anglesInQ16Degree, const uint16_t* distances, float* rangesInMillimeter, float* correctedAnglesInDegree){
+  distancesInMillimeter(distances, lenght, rangesInMillimeter);
+  for(size_t sampleNum=0; sampleNum<lenght; sampleNum++){
+    correctedAnglesInDegree[sampleNum] = wrapAngleInDegree(anglesInQ16Degree[sampleNum] * (1.0f/65536) + angleCorrection.inDegree(distances[sampleNum]));
+  }
+}
+
+void YDLidarX4StateMachine::calculateFixedPointAnglesFromSamples(size_t lenght, const int32_t* anglesInQ16Degree, const uint16_t* distances, uint16_t* correctedAnglesInQ6Degree){
+  const int32_t fullCircleInQ6Degree = 360*64;
+  for(size_t sampleNum=0; sampleNum<lenght; sampleNum++){
+    int32_t correctedAngleInQ6Degree = (anglesInQ16Degree[sampleNum] + angleCorrection.inFixedPoint(distances[sampleNum]) + 512) >> 10;
+    if(correctedAngleInQ6Degree < 0){
+      correctedAngleInQ6Degree += fullCircleInQ6Degree;
+    }else if(correctedAngleInQ6Degree >= fullCircleInQ6Degree){
+      correctedAngleInQ6Degree -= fullCircleInQ6Degree;
+    }
+    correctedAnglesInQ6Degree[sampleNum] = correctedAngleInQ6Degree;
   }
 }
 
@@ -371,19 +826,10 @@ void YDLidarX4StateMachine::printRangesAndAnglesFromPaket(bool isIndexPaket, siz
   // trace->printf("PKG: angles %f° - %f° => %d messures\n", minAngleInDegree, maxAngleInDegree, lenght);
 }
 
-float YDLidarX4StateMachine::calculateAngleInDegree(float distanceValue_i, float startAngleInDegree, float stopAngleInDegree, uint16_t sampleNum, uint8_t sampleQuantity){
-  float angleInDegree_i;
-  if(sampleQuantity==1){
-    // prevent DIV0-error
-    angleInDegree_i = startAngleInDegree;
-  }else{
-    angleInDegree_i = startAngleInDegree + sampleNum * (stopAngleInDegree - startAngleInDegree)/(sampleQuantity - 1);
-  }
-  float angleInDegree_correced_i = angleInDegree_i + calculateCorrectingAngleInDegree(distanceValue_i);
-  return angleInDegree_correced_i;
-}
-
 void YDLidarX4StateMachine::notifyHandlers(bool isIndexPaket, float minAngleInDegree, float maxAngleInDegree, float correctedAnglesInDegree[], float rangesInMillimeter[], size_t lenght){
+  if(packetCallback != nullptr){
+    packetCallback(packetCallbackContext, minAngleInDegree, maxAngleInDegree, correctedAnglesInDegree, rangesInMillimeter, lenght);
+  }
   if(isIndexPaket){
     notifyIndexPacketHandler(minAngleInDegree, maxAngleInDegree, correctedAnglesInDegree, rangesInMillimeter);
   }else{
@@ -408,8 +854,133 @@ void YDLidarX4StateMachine::notifyPacketHandler(float minAngleInDegree, float ma
   }
 }
 
+YDLidarX4StateMachine::State YDLidarX4StateMachine::resyncOrError(){
+  if(!resyncOnError){
+    return ERROR;
+  }
+  resyncCount++;
+  return SCAN_RESYNC;
+}
+
+// drop the corrupt bytes up to the next 0xAA 0x55 paket header and keep on scanning
+YDLidarX4StateMachine::State YDLidarX4StateMachine::handleStateScanResync(){
+  LidarQueueView<uint8_t> bytes;
+  if(!queue.view(queue.size(), bytes) || bytes.size() == 0){
+    return SCAN_RESYNC;
+  }
+
+  size_t headerPosition = findPaketHeader(bytes);
+  removeFromQueue(headerPosition);
+  resyncDiscardedBytes += headerPosition;
+  IF_DEBUG debug->printf("   ### resync: dropped %lu bytes\n", (unsigned long)headerPosition);
+
+  if(headerPosition+1 >= bytes.size()){
+    // no complete header found yet - a trailing 0xAA is kept for the next try
+    return SCAN_RESYNC;
+  }
+  return SCAN_NEED_HEADER;
+}
+
+// position of the first 0xAA 0x55, of a trailing 0xAA or the size of the view if there is none
+size_t YDLidarX4StateMachine::findPaketHeader(LidarQueueView<uint8_t> &bytes){
+  size_t position = 0;
+  while(position < bytes.size()){
+    position = findByte(bytes, 0xAA, position);
+    if(position+1 >= bytes.size() || bytes[position+1] == 0x55){
+      return position;
+    }
+    position++;
+  }
+  return bytes.size();
+}
+
+size_t YDLidarX4StateMachine::findByte(LidarQueueView<uint8_t> &bytes, uint8_t value, size_t startPosition){
+  if(startPosition < bytes.firstSize){
+    const void *found = memchr(bytes.first+startPosition, value, bytes.firstSize-startPosition);
+    if(found != nullptr){
+      return (const uint8_t*)found - bytes.first;
+    }
+    startPosition = bytes.firstSize;
+  }
+  size_t positionInSecond = startPosition - bytes.firstSize;
+  if(positionInSecond < bytes.secondSize){
+    const void *found = memchr(bytes.second+positionInSecond, value, bytes.secondSize-positionInSecond);
+    if(found != nullptr){
+      return bytes.firstSize + ((const uint8_t*)found - bytes.second);
+    }
+  }
+  return bytes.size();
+}
+
+int32_t YDLidarX4StateMachine::fixedPointStepInQ16Degree(uint16_t startAngleInQ6Degree, uint16_t stopAngleInQ6Degree, uint8_t sampleQuantity){
+  int32_t diffInQ6Degree = (int32_t)stopAngleInQ6Degree - startAngleInQ6Degree;
+  if(diffInQ6Degree < 0){
+    diffInQ6Degree += 360*64;
+  }
+  return sampleQuantity > 1 ? (diffInQ6Degree << 10) / (sampleQuantity - 1) : 0;
+}
+
+// uncorrected angle of one sample of the paket
+uint16_t YDLidarX4StateMachine::interpolatedAngleInQ6Degree(uint16_t startAngleInQ6Degree, uint16_t stopAngleInQ6Degree, uint8_t sampleQuantity, uint8_t sampleNum){
+  int32_t angleInQ16Degree = ((int32_t)startAngleInQ6Degree << 10) + sampleNum * fixedPointStepInQ16Degree(startAngleInQ6Degree, stopAngleInQ6Degree, sampleQuantity);
+  int32_t angle = (angleInQ16Degree + 512) >> 10;
+  return angle < 360*64 ? angle : angle - 360*64;
+}
+
+float YDLidarX4StateMachine::interpolatedAngleInDegree(float startAngleInDegree, float stopAngleInDegree, uint8_t sampleQuantity, uint8_t sampleNum){
+  float diffInDegree = stopAngleInDegree - startAngleInDegree;
+  if(diffInDegree < 0){
+    diffInDegree += 360;
+  }
+  float stepInDegree = sampleQuantity > 1 ? diffInDegree / (sampleQuantity - 1) : 0;
+  return wrapAngleInDegree(startAngleInDegree + sampleNum * stepInDegree);
+}
+
+// the revolution based stages, the index packet ends the revolution before its sample is added
+void YDLidarX4StateMachine::handleFrame(bool isIndexPaket, const LidarPacketTime &time, float correctedAnglesInDegree[], float rangesInMillimeter[], size_t lenght){
+  if(clusterExtractor != nullptr){
+    if(isIndexPaket){
+      clusterExtractor->finishRevolution();
+    }
+    clusterExtractor->add(correctedAnglesInDegree, rangesInMillimeter, lenght);
+  }
+  if(frameAssembler == nullptr){
+    return;
+  }
+  if(isIndexPaket){
+    LidarFrame *finishedFrame = frameAssembler->startRevolution();
+    if(finishedFrame != nullptr && frameHandler != nullptr){
+      frameHandler->operator()(*finishedFrame);
+    }
+  }
+  if(lenght == 0){
+    return;
+  }
+  frameAssembler->add(correctedAnglesInDegree, rangesInMillimeter, lenght, time.firstSampleTimeInMicros, time.sampleTimeInMicros(lenght-1));
+}
+
+void YDLidarX4StateMachine::notifyPointCloudHandlers(uint16_t correctedAnglesInQ6Degree[], uint16_t rangesInQuarterMillimeter[], size_t lenght){
+  if(pointCloudHandler != nullptr){
+    size_t pointCount = cartesianConverter.toPoints(correctedAnglesInQ6Degree, rangesInQuarterMillimeter, lenght, scratch->points);
+    pointCloudHandler->operator()(scratch->points, pointCount);
+  }
+  if(floatPointCloudHandler != nullptr){
+    size_t pointCount = cartesianConverter.toPoints(correctedAnglesInQ6Degree, rangesInQuarterMillimeter, lenght, scratch->floatPoints);
+    floatPointCloudHandler->operator()(scratch->floatPoints, pointCount);
+  }
+}
+
+void YDLidarX4StateMachine::notifyFixedPointPacketHandler(uint16_t minAngleInQ6Degree, uint16_t maxAngleInQ6Degree, uint16_t correctedAnglesInQ6Degree[], uint16_t rangesInQuarterMillimeter[], size_t lenght){
+  if(fixedPointPacketCallback != nullptr){
+    fixedPointPacketCallback(fixedPointPacketCallbackContext, minAngleInQ6Degree, maxAngleInQ6Degree, correctedAnglesInQ6Degree, rangesInQuarterMillimeter, lenght);
+  }
+  if(fixedPointPacketHandler != nullptr){
+    fixedPointPacketHandler->operator()(minAngleInQ6Degree, maxAngleInQ6Degree, correctedAnglesInQ6Degree, rangesInQuarterMillimeter, lenght);
+  }
+}
+
 YDLidarX4StateMachine::State YDLidarX4StateMachine::handleStateStop(){
-  queue.clear();
+  clearQueue();
   return END;
 }
 
@@ -527,22 +1098,43 @@ string YDLidarX4StateMachine::hex(uint16_t value){
 }
 
 // --- helper funktions ---------------------------------------------------------------------
+uint8_t YDLidarX4StateMachine::paketByte(size_t position){
+  return paket[position];
+}
+
+// little endian, a word may be split by the wrap around of the queue
+uint16_t YDLidarX4StateMachine::paketWord(size_t position){
+  return paket[position] | (paket[position+1] << 8);
+}
+
+uint16_t YDLidarX4StateMachine::paketSample(uint16_t sampleNum){
+  return paketWord(sampleBeginPos + 2*sampleNum);
+}
+
+uint16_t YDLidarX4StateMachine::paketChecksum(){
+  uint16_t checksum = xorChecksum16(paket.first, paket.firstSize);
+  uint16_t checksumOfSecondPart = xorChecksum16(paket.second, paket.secondSize);
+  if(paket.firstSize % 2 == 1){
+    // the second part starts at an odd paket position -> its bytes are swapped
+    checksumOfSecondPart = (checksumOfSecondPart << 8) | (checksumOfSecondPart >> 8);
+  }
+  return checksum ^ checksumOfSecondPart;
+}
+
 float YDLidarX4StateMachine::angleInDegree(uint16_t value){
   uint16_t value_shifted = (value>>1);
   double angle = value_shifted/64.0;
   return angle;
 }
 
+// angle in 1/64 degree
+uint16_t YDLidarX4StateMachine::angleInQ6Degree(uint16_t value){
+  return value>>1;
+}
+
 // tested : 0x6fe5 should be 7161.25mm = 7161.25
 float YDLidarX4StateMachine::distanceInMillimeter(uint16_t value){
   return value/4.0;
 }
-float YDLidarX4StateMachine::calculateCorrectingAngleInDegree(float distance){
-  if(distance == 0){
-    return 0;
-  }
-  static float inDegree = 180/3.14159265359;
-  return atan(21.8*((155.3-distance)/(155.3*distance)))*inDegree;
-}
 
 } // end namespace
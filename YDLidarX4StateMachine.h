@@ -2,9 +2,22 @@
 #define __YD_Lidar_X4_STATE_MACHINE__
 
 #include <Arduino.h>
-#include <SynchronizedQueue.h>
+#include <LidarQueue.h>
 #include <string>
+#include <memory>
 #include <LogLevel.h>
+#include <AngleCorrection.h>
+#include <FrameAssembler.h>
+#include <PolarGrid.h>
+#include <CartesianConverter.h>
+#include <ReceiveTimestamps.h>
+#include <ScanRateEstimator.h>
+#include <RangeFilter.h>
+#include <AngularRoi.h>
+#include <Decimator.h>
+#include <NearestObstacleTracker.h>
+#include <OccupancyGrid.h>
+#include <ClusterExtractor.h>
 
 using std::string;
 
@@ -13,9 +26,48 @@ using std::string;
 
 namespace sensorYDLidarX4 {
 
+// decoded responses of the lidar
+struct LidarHealthStatus{
+  uint8_t status;       // 0: ok, 1: warning, 2: error
+  uint16_t errorCode;
+};
+
+struct LidarDeviceInfo{
+  uint8_t model;
+  uint8_t firmwareMajor;
+  uint8_t firmwareMinor;
+  uint8_t hardware;
+  uint8_t serialNumber[16];
+};
+
+// acquisition time of a paket, the receive time is the doReceive() call which received its last byte
+struct LidarPacketTime{
+  unsigned long receiveTimeInMicros;
+  unsigned long firstSampleTimeInMicros;
+  float samplePeriodInMicros;
+
+  unsigned long sampleTimeInMicros(size_t sampleNum) const{
+    return firstSampleTimeInMicros + (unsigned long)(sampleNum * samplePeriodInMicros);
+  }
+};
+
 // define packet handler lambda interfaces
 typedef std::function<void(float minAngleInDegree, float maxAngleInDegree, float correctedAnglesInDegree[], float rangesInMillimeter[], size_t lenght)> OnLidarPacketHandler;
 typedef std::function<void(float angleInDegree, float correctedAngleInDegree, float rangeInMillimeter)> OnLidarIndexPacketHandler;
+// fixed point variant without any float: angles in 1/64 degree [0, 360*64), ranges in 0.25mm
+typedef std::function<void(uint16_t minAngleInQ6Degree, uint16_t maxAngleInQ6Degree, uint16_t correctedAnglesInQ6Degree[], uint16_t rangesInQuarterMillimeter[], size_t lenght)> OnLidarFixedPointPacketHandler;
+typedef std::function<void(const LidarPacketTime &time, float correctedAnglesInDegree[], float rangesInMillimeter[], size_t lenght)> OnLidarTimedPacketHandler;
+// plain function pointer alternative to the packet handlers: no type erasure and no allocation,
+// context is passed through unchanged. all pakets are delivered, index packets with lenght 1
+typedef void (*LidarPacketCallback)(void *context, float minAngleInDegree, float maxAngleInDegree, float correctedAnglesInDegree[], float rangesInMillimeter[], size_t lenght);
+typedef void (*LidarFixedPointPacketCallback)(void *context, uint16_t minAngleInQ6Degree, uint16_t maxAngleInQ6Degree, uint16_t correctedAnglesInQ6Degree[], uint16_t rangesInQuarterMillimeter[], size_t lenght);
+// x/y in the frame of the robot (see CartesianConverter), samples without range are skipped
+typedef std::function<void(LidarPoint points[], size_t lenght)> OnLidarPointCloudHandler;
+typedef std::function<void(LidarFloatPoint points[], size_t lenght)> OnLidarFloatPointCloudHandler;
+// a full revolution, valid until the next frame is finished
+typedef std::function<void(LidarFrame &frame)> OnLidarFrameHandler;
+typedef std::function<void(LidarHealthStatus &healthStatus)> OnLidarHealthStatusHandler;
+typedef std::function<void(LidarDeviceInfo &deviceInfo)> OnLidarDeviceInfoHandler;
 
 class YDLidarX4StateMachine{
 private:
@@ -32,6 +84,15 @@ private:
     scanPacket=0x00,
     indexPacket=0x01
   };
+  enum YDLidarX4Response{
+    responseLength=2,
+    responseType=6,
+    responsePayloadPos=7
+  };
+  enum YDLidarX4ResponseType{
+    deviceInfoResponse=0x04,
+    healthStatusResponse=0x06
+  };
   enum State {
     IDLE,
     READY,
@@ -44,35 +105,75 @@ private:
     SCAN_NEED_DATA,
     SCAN_CHECK_CRC,
     SCAN_SEND_MESSAGE,
+    SCAN_RESYNC,
+    SCAN_NEED_RESPONSE_DATA,
     STOP,
     TIMEOUT,
     END,
     ERROR
   };
 
-  union Paket{
-    uint8_t rawData[sampleBeginPos+sizeof(uint16_t)*256]; // sampleBeginPos + 2Bytes * sizeof(packetSampleQuantity) = 10+2*256
-    struct {
-      uint16_t header;
-      uint8_t type;
-      uint8_t quantity;
-      uint16_t startAngle;
-      uint16_t lastAngle;
-      uint16_t checkSum;
-      uint16_t samples[256];
-    }__attribute__((packed));
-  }__attribute__((packed));
-  
-
   State state;
-  SynchronizedQueue<uint8_t> &queue;
+  LidarQueue<uint8_t> &queue;
   OnLidarPacketHandler *packetHandler;
   OnLidarIndexPacketHandler *indexPacketHandler;
+  OnLidarFixedPointPacketHandler *fixedPointPacketHandler;
+  LidarPacketCallback packetCallback;
+  void *packetCallbackContext;
+  LidarFixedPointPacketCallback fixedPointPacketCallback;
+  void *fixedPointPacketCallbackContext;
+  OnLidarTimedPacketHandler *timedPacketHandler;
+  OnLidarFrameHandler *frameHandler;
+  FrameAssembler *frameAssembler;
+  ClusterExtractor *clusterExtractor;
+  PolarGrid *polarGrid;
+  NearestObstacleTracker *nearestObstacleTracker;
+  OccupancyGrid *occupancyGrid;
+  AngularRoi *angularRoi;
+  RangeFilter *rangeFilter;
+  Decimator *decimator;
+  OnLidarPointCloudHandler *pointCloudHandler;
+  OnLidarFloatPointCloudHandler *floatPointCloudHandler;
+  OnLidarHealthStatusHandler *healthStatusHandler;
+  OnLidarDeviceInfoHandler *deviceInfoHandler;
   Print *debug;
   Print *trace;
   LogLevel logLevel;
-  Paket paket;
+  unsigned long decodedPaketCount;
+  uint16_t revolutionCount;
+  AngleCorrection angleCorrection;
+  bool isAngleCorrectionFallback;
+  ReceiveTimestamps *receiveTimestamps;
+  ScanRateEstimator scanRate;
+  size_t samplesInRevolution;
+  CartesianConverter cartesianConverter;
+  bool resyncOnError;
+  unsigned long resyncCount;
+  unsigned long resyncDiscardedBytes;
+  LidarQueueView<uint8_t> paket; // zero copy view of the current paket inside the queue
   size_t expectedPaketSize;
+  size_t expectedResponseSize;
+
+  // output buffers for one paket on the heap instead of arrays on the stack (and cheap to move),
+  // the sample quantity is an uint8_t. the decimator never returns more samples than it gets
+  const static size_t maxSamplesPerPaket = 255;
+  struct PaketScratch{
+    uint16_t distances[maxSamplesPerPaket];
+    int32_t anglesInQ16Degree[maxSamplesPerPaket];
+    int32_t decimatedAnglesInQ16Degree[maxSamplesPerPaket];
+    uint16_t decimatedDistances[maxSamplesPerPaket];
+    uint16_t anglesInQ6Degree[maxSamplesPerPaket];
+    float rangesInMillimeter[maxSamplesPerPaket];
+    float anglesInDegree[maxSamplesPerPaket];
+    union{
+      LidarPoint points[maxSamplesPerPaket];
+      LidarFloatPoint floatPoints[maxSamplesPerPaket];
+    };
+  };
+  std::unique_ptr<PaketScratch> scratch;
+
+  // 128000 baud 8N1
+  const static unsigned long byteTimeInNanos = 78125;
 
   // start stream expectations
   const static size_t startHeaderSize = 7;
@@ -80,6 +181,12 @@ private:
     0xA5, 0x5A, 0x05, 0x00, 0x00, 0x40, 0x81,
   };
 
+  // responses while scanning: header (0xA5 0x5A, length, type) + payload
+  const static size_t responseHeaderSize = responsePayloadPos;
+  const static size_t maxResponsePayloadSize = 32;
+  const static size_t deviceInfoPayloadSize = 20;
+  const static size_t healthStatusPayloadSize = 3;
+
   // state handler
   State handleState();
   State handleStateIdle();
@@ -90,23 +197,56 @@ private:
   bool isCorrectStartPaket();
   State handleStateStartRemovePaket();
   bool removeBytesFromQueue(uint16_t byteCountToRemove);
+  void removeFromQueue(size_t size);
+  void clearQueue();
   State handleStateScanNeedHeader();
   State handleStateScanNeedSize();
   State handleStateScanNeedData();
-  uint16_t getScanPaketExpectedSize();
+  uint16_t getScanPaketExpectedSize(uint8_t paketSize);
   State handleStateScanCheckCrc();
   bool isCorrectCrc();
   State handleStateScanSendMessages();
+  State handleStateScanResync();
+  State handleStateScanNeedResponseData();
+  uint32_t getResponsePayloadSize(uint8_t *header);
+  void handleResponse(uint8_t type, uint8_t *payload, size_t payloadSize);
+  void handleHealthStatusResponse(uint8_t *payload);
+  void handleDeviceInfoResponse(uint8_t *payload);
+  State resyncOrError();
+  size_t findPaketHeader(LidarQueueView<uint8_t> &bytes);
+  size_t findByte(LidarQueueView<uint8_t> &bytes, uint8_t value, size_t startPosition);
   void handleValidPacket();
   State handleStateStop();
   State handleStateTimeout();
 
-  void calculateRangesAndAnglesFromPaket(Paket &paket, uint8_t sampleQuantity, float startAngleInDegree, float stopAngleInDegree, float* ranges, float* anglesInDegree);
+  uint8_t paketByte(size_t position);
+  uint16_t paketWord(size_t position);
+  uint16_t paketSample(uint16_t sampleNum);
+  uint16_t paketChecksum();
+
+  void calculateRangesAndAnglesFromPaket(uint8_t sampleQuantity, float startAngleInDegree, float stopAngleInDegree, const uint16_t* distances, float* ranges, float* anglesInDegree);
+  void calculateFixedPointAnglesFromPaket(uint8_t paketSampleQuantity, uint16_t startAngleInQ6Degree, uint16_t stopAngleInQ6Degree, uint8_t firstSample, uint8_t sampleQuantity, const uint16_t* distances, uint16_t* correctedAnglesInQ6Degree);
+  size_t decimatePaket(uint8_t paketSampleQuantity, uint16_t startAngleInQ6Degree, uint16_t stopAngleInQ6Degree, uint8_t firstSample, uint8_t sampleQuantity, const uint16_t* distances);
+  void flushDecimator(const LidarPacketTime &indexPaketTime);
+  void handleDecimatedSamples(bool isIndexPaket, const LidarPacketTime &time, size_t lenght);
+  void calculateRangesAndAnglesFromSamples(size_t lenght, const int32_t* anglesInQ16Degree, const uint16_t* distances, float* ranges, float* anglesInDegree);
+  void calculateFixedPointAnglesFromSamples(size_t lenght, const int32_t* anglesInQ16Degree, const uint16_t* distances, uint16_t* correctedAnglesInQ6Degree);
+  int32_t fixedPointStepInQ16Degree(uint16_t startAngleInQ6Degree, uint16_t stopAngleInQ6Degree, uint8_t sampleQuantity);
+  uint16_t interpolatedAngleInQ6Degree(uint16_t startAngleInQ6Degree, uint16_t stopAngleInQ6Degree, uint8_t sampleQuantity, uint8_t sampleNum);
+  float interpolatedAngleInDegree(float startAngleInDegree, float stopAngleInDegree, uint8_t sampleQuantity, uint8_t sampleNum);
+  bool hasFloatOutput();
+  bool hasFixedPointOutput();
   void printRangesAndAnglesFromPaket(bool isIndexPaket, size_t lenght, float minAngleInDegree, float maxAngleInDegree, float anglesInDegree[], float ranges[]);
   // notify the handlers
   void notifyHandlers(bool isIndexPaket, float minAngleInDegree, float maxAngleInDegree, float anglesInDegree[], float ranges[], size_t lenght);
   void notifyIndexPacketHandler(float minAngleInDegree, float maxAngleInDegree, float anglesInDegree[], float ranges[]);
   void notifyPacketHandler(float minAngleInDegree, float maxAngleInDegree, float anglesInDegree[], float ranges[], size_t lenght);
+  LidarPacketTime calculatePaketTime(bool isIndexPaket, uint8_t sampleQuantity);
+  void handleFrame(bool isIndexPaket, const LidarPacketTime &time, float anglesInDegree[], float ranges[], size_t lenght);
+  void notifyPointCloudHandlers(uint16_t anglesInQ6Degree[], uint16_t ranges[], size_t lenght);
+  void notifyFixedPointPacketHandler(uint16_t minAngleInQ6Degree, uint16_t maxAngleInQ6Degree, uint16_t anglesInQ6Degree[], uint16_t ranges[], size_t lenght);
+  void notifyFixedPointOutputs(uint16_t minAngleInQ6Degree, uint16_t maxAngleInQ6Degree, uint16_t anglesInQ6Degree[], uint16_t ranges[], size_t lenght);
+  void notifyFloatOutputs(bool isIndexPaket, const LidarPacketTime &time, float minAngleInDegree, float maxAngleInDegree, float anglesInDegree[], float ranges[], size_t lenght);
 
   // internal helper funktions
   string getState(State lidarState);
@@ -115,14 +255,15 @@ private:
   string hex(uint16_t value);
 
   // lidar calc helper funktions
-  float calculateAngleInDegree(float distanceValue_i, float startAngleInDegree, float stopAngleInDegree, uint16_t sampleNum, uint8_t sampleQuantity);
   float angleInDegree(uint16_t value);
+  uint16_t angleInQ6Degree(uint16_t value);
   float distanceInMillimeter(uint16_t value);
-  float calculateCorrectingAngleInDegree(float distance);
 
 public:
-  YDLidarX4StateMachine(SynchronizedQueue<uint8_t> &queue, OnLidarPacketHandler *callback, OnLidarIndexPacketHandler *indexPacketHandler, Print *debug, Print *trace, LogLevel logLevel);
+  YDLidarX4StateMachine(LidarQueue<uint8_t> &queue, OnLidarPacketHandler *callback, OnLidarIndexPacketHandler *indexPacketHandler, Print *debug, Print *trace, LogLevel logLevel);
+  YDLidarX4StateMachine(YDLidarX4StateMachine &&other) = default;
   bool runOne();
+  size_t runBatch();
   
   void setStateIdle();
   void setStateStop();
@@ -133,6 +274,33 @@ public:
   bool hasTimeout();
   bool isScanning();
   string getState();
+  unsigned long getDecodedPaketCount();
+  uint16_t getRevolutionCount();
+  float getScanFrequencyInHz();
+  float getScanPeriodJitterInMicros();
+  unsigned long getLastIndexPacketTimeInMicros();
+  void setResyncOnError(bool resyncOnError);
+  void setAngleCorrectionMode(AngleCorrectionMode angleCorrectionMode);
+  // true if the full table did not fit into the heap and the interpolated one is used
+  bool hasAngleCorrectionFallback();
+  void setFixedPointPacketHandler(OnLidarFixedPointPacketHandler *fixedPointPacketHandler);
+  void setPacketCallback(LidarPacketCallback packetCallback, void *context);
+  void setFixedPointPacketCallback(LidarFixedPointPacketCallback fixedPointPacketCallback, void *context);
+  void setTimedPacketHandler(OnLidarTimedPacketHandler *timedPacketHandler);
+  void setReceiveTimestamps(ReceiveTimestamps *receiveTimestamps);
+  void setFrameHandler(FrameAssembler *frameAssembler, OnLidarFrameHandler *frameHandler);
+  void setClusterExtractor(ClusterExtractor *clusterExtractor);
+  void setPolarGrid(PolarGrid *polarGrid);
+  void setNearestObstacleTracker(NearestObstacleTracker *nearestObstacleTracker);
+  void setOccupancyGrid(OccupancyGrid *occupancyGrid);
+  void setRangeFilter(RangeFilter *rangeFilter);
+  void setAngularRoi(AngularRoi *angularRoi);
+  void setDecimator(Decimator *decimator);
+  void setPointCloudHandlers(OnLidarPointCloudHandler *pointCloudHandler, OnLidarFloatPointCloudHandler *floatPointCloudHandler);
+  void setMountingOffset(int16_t offsetXInMillimeter, int16_t offsetYInMillimeter, float rotationInDegree);
+  void setResponseHandlers(OnLidarHealthStatusHandler *healthStatusHandler, OnLidarDeviceInfoHandler *deviceInfoHandler);
+  unsigned long getResyncCount();
+  unsigned long getResyncDiscardedBytes();
 
   void debugPrintQueue(const char *message="");
   void debugPrintQueue(Print* out, const char *message="");
@@ -0,0 +1,238 @@
+/*
+This example was tested on a ESP32
+
+It needs no lidar. It measures the computing kernels of the library
+on random data and prints the time per call on the serial monitor.
+*/
+
+#include <YDLidarX4.h>
+#include <XorChecksum.h>
+#include <AngleCorrection.h>
+#include <AngleInterpolation.h>
+#include <CartesianConverter.h>
+#include <OccupancyGrid.h>
+#include <LineSegmentExtractor.h>
+
+using sensorYDLidarX4::AngleCorrection;
+
+#define BENCHMARK_ITERATIONS 10000
+
+// a scan paket with the maximum of 256 samples
+uint8_t paket[10+2*256];
+volatile uint16_t sink;
+volatile float floatSink;
+
+// the checksum loop as it was before: one uint16_t per sample
+uint16_t xorChecksumPerWord(const uint8_t *data, size_t length){
+  uint16_t checksum = 0;
+  for(size_t position=0; position+1<length; position+=2){
+    checksum ^= data[position] | (data[position+1] << 8);
+  }
+  return checksum;
+}
+
+void printResult(const char *name, unsigned long startMicros, unsigned long stopMicros){
+  float nanosecondsPerCall = (stopMicros - startMicros) * 1000.0 / BENCHMARK_ITERATIONS;
+  Serial.printf("%-32s %10.1f ns/call\n", name, nanosecondsPerCall);
+}
+
+void printSamplesPerSecond(const char *name, unsigned long startMicros, unsigned long stopMicros, size_t samplesPerCall){
+  float samplesPerSecond = (float)BENCHMARK_ITERATIONS * samplesPerCall * 1000000.0 / (stopMicros - startMicros);
+  Serial.printf("%-32s %10.0f samples/s\n", name, samplesPerSecond);
+}
+
+void benchmarkChecksum(){
+  unsigned long start = micros();
+  for(int i=0; i<BENCHMARK_ITERATIONS; i++){
+    sink ^= xorChecksumPerWord(paket, sizeof(paket));
+  }
+  printResult("checksum per word", start, micros());
+
+  start = micros();
+  for(int i=0; i<BENCHMARK_ITERATIONS; i++){
+    sink ^= sensorYDLidarX4::xorChecksum16(paket, sizeof(paket));
+  }
+  printResult("checksum xorChecksum16", start, micros());
+}
+
+void benchmarkAngleCorrection(const char *name, AngleCorrection &angleCorrection){
+  // raw distances of the X4 range 0.12m - 10m in 0.25mm steps
+  unsigned long start = micros();
+  for(int i=0; i<BENCHMARK_ITERATIONS; i++){
+    uint16_t distance = 480 + (i * 4) % 39520;
+    floatSink += angleCorrection.inDegree(distance);
+  }
+  printResult(name, start, micros());
+}
+
+void benchmarkAngleCorrections(){
+  AngleCorrection exact;
+  benchmarkAngleCorrection("angle correction exact", exact);
+
+  AngleCorrection interpolated;
+  interpolated.setMode(sensorYDLidarX4::ANGLE_CORRECTION_INTERPOLATED);
+  benchmarkAngleCorrection("angle correction interpolated", interpolated);
+
+  AngleCorrection table;
+  if(table.setMode(sensorYDLidarX4::ANGLE_CORRECTION_TABLE)){
+    benchmarkAngleCorrection("angle correction table", table);
+  }else{
+    Serial.println("angle correction table: not enough heap");
+  }
+}
+
+// the per sample path before the kernel, as YDLidarX4StateMachine::calculateAngleInDegree() was
+float calculateAngleInDegree(AngleCorrection &angleCorrection, uint16_t distance_i, float startAngleInDegree, float stopAngleInDegree, uint16_t sampleNum, uint8_t sampleQuantity){
+  float angleInDegree_i;
+  if(sampleQuantity==1){
+    // prevent DIV0-error
+    angleInDegree_i = startAngleInDegree;
+  }else{
+    angleInDegree_i = startAngleInDegree + sampleNum * (stopAngleInDegree - startAngleInDegree)/(sampleQuantity - 1);
+  }
+  float angleInDegree_correced_i = angleInDegree_i + angleCorrection.inDegree(distance_i);
+  return angleInDegree_correced_i;
+}
+
+// one scan paket with 40 samples (the usual X4 paket size) per iteration,
+// ranges and corrected angles as calculateRangesAndAnglesFromPaket() before and after the kernel
+void benchmarkAngleInterpolation(const char *name, AngleCorrection &angleCorrection){
+  const size_t sampleQuantity = 40;
+  const uint16_t *distances = (const uint16_t*)&paket[10];
+  float rangesInMillimeter[sampleQuantity];
+  float anglesInDegree[sampleQuantity];
+  char label[64];
+
+  unsigned long start = micros();
+  for(int i=0; i<BENCHMARK_ITERATIONS; i++){
+    float startAngleInDegree = i % 360;
+    float stopAngleInDegree = startAngleInDegree + 20;
+    for(size_t sampleNum=0; sampleNum<sampleQuantity; sampleNum++){
+      rangesInMillimeter[sampleNum] = distances[sampleNum]/4.0;
+      anglesInDegree[sampleNum] = calculateAngleInDegree(angleCorrection, distances[sampleNum], startAngleInDegree, stopAngleInDegree, sampleNum, sampleQuantity);
+    }
+    floatSink += rangesInMillimeter[i % sampleQuantity] + anglesInDegree[i % sampleQuantity];
+  }
+  snprintf(label, sizeof(label), "per sample (%s)", name);
+  printSamplesPerSecond(label, start, micros(), sampleQuantity);
+
+  start = micros();
+  for(int i=0; i<BENCHMARK_ITERATIONS; i++){
+    float startAngleInDegree = i % 360;
+    float stopAngleInDegree = startAngleInDegree + 20;
+    sensorYDLidarX4::distancesInMillimeter(distances, sampleQuantity, rangesInMillimeter);
+    sensorYDLidarX4::interpolateAnglesInDegree(startAngleInDegree, stopAngleInDegree, sampleQuantity, anglesInDegree);
+    for(size_t sampleNum=0; sampleNum<sampleQuantity; sampleNum++){
+      anglesInDegree[sampleNum] = sensorYDLidarX4::wrapAngleInDegree(anglesInDegree[sampleNum] + angleCorrection.inDegree(distances[sampleNum]));
+    }
+    floatSink += rangesInMillimeter[i % sampleQuantity] + anglesInDegree[i % sampleQuantity];
+  }
+  snprintf(label, sizeof(label), "kernel (%s)", name);
+  printSamplesPerSecond(label, start, micros(), sampleQuantity);
+}
+
+void benchmarkAngleInterpolations(){
+  AngleCorrection exact;
+  benchmarkAngleInterpolation("exact", exact);
+
+  AngleCorrection interpolated;
+  interpolated.setMode(sensorYDLidarX4::ANGLE_CORRECTION_INTERPOLATED);
+  benchmarkAngleInterpolation("interpolated", interpolated);
+}
+
+void benchmarkCartesian(){
+  const size_t sampleQuantity = 40;
+  uint16_t anglesInQ6Degree[sampleQuantity];
+  uint16_t rangesInQuarterMillimeter[sampleQuantity];
+  sensorYDLidarX4::LidarPoint points[sampleQuantity];
+  for(size_t sampleNum=0; sampleNum<sampleQuantity; sampleNum++){
+    anglesInQ6Degree[sampleNum] = random(360*64);
+    rangesInQuarterMillimeter[sampleNum] = 1 + random(40000);
+  }
+
+  unsigned long start = micros();
+  for(int i=0; i<BENCHMARK_ITERATIONS; i++){
+    for(size_t sampleNum=0; sampleNum<sampleQuantity; sampleNum++){
+      float angleInRad = anglesInQ6Degree[sampleNum] / 64.0 * DEG_TO_RAD;
+      float rangeInMillimeter = rangesInQuarterMillimeter[sampleNum] / 4.0;
+      points[sampleNum].xInMillimeter = rangeInMillimeter * cos(angleInRad);
+      points[sampleNum].yInMillimeter = rangeInMillimeter * sin(angleInRad);
+    }
+    sink ^= points[i % sampleQuantity].xInMillimeter;
+  }
+  printSamplesPerSecond("cartesian sin/cos", start, micros(), sampleQuantity);
+
+  sensorYDLidarX4::CartesianConverter cartesianConverter;
+  start = micros();
+  for(int i=0; i<BENCHMARK_ITERATIONS; i++){
+    cartesianConverter.toPoints(anglesInQ6Degree, rangesInQuarterMillimeter, sampleQuantity, points);
+    sink ^= points[i % sampleQuantity].xInMillimeter;
+  }
+  printSamplesPerSecond("cartesian table", start, micros(), sampleQuantity);
+}
+
+// rays of 40 samples up to 5m into a 10m x 10m grid with 5cm cells
+void benchmarkOccupancyGrid(){
+  const size_t sampleQuantity = 40;
+  uint16_t anglesInQ6Degree[sampleQuantity];
+  uint16_t rangesInQuarterMillimeter[sampleQuantity];
+  for(size_t sampleNum=0; sampleNum<sampleQuantity; sampleNum++){
+    anglesInQ6Degree[sampleNum] = random(360*64);
+    rangesInQuarterMillimeter[sampleNum] = 1 + random(20000);
+  }
+
+  sensorYDLidarX4::OccupancyGrid occupancyGrid(200, 200, 50);
+  occupancyGrid.setPose(5000, 5000, 0);
+  unsigned long start = micros();
+  for(int i=0; i<BENCHMARK_ITERATIONS; i++){
+    occupancyGrid.update(anglesInQ6Degree, rangesInQuarterMillimeter, sampleQuantity);
+  }
+  unsigned long stop = micros();
+  printSamplesPerSecond("occupancy grid", start, stop, sampleQuantity);
+  float cellsPerSecond = occupancyGrid.getCellUpdateCount() * 1000000.0 / (stop - start);
+  Serial.printf("%-32s %10.0f cells/s\n", "occupancy grid", cellsPerSecond);
+}
+
+// one revolution of 720 samples in a 6m x 4m room, the lidar 1m/0.5m off center
+void benchmarkLineSegments(){
+  const size_t sampleQuantity = 720;
+  static float anglesInDegree[sampleQuantity];
+  static float rangesInMillimeter[sampleQuantity];
+  const float wallX[2] = {-4000, 2000};
+  const float wallY[2] = {-2500, 1500};
+  for(size_t sampleNum=0; sampleNum<sampleQuantity; sampleNum++){
+    anglesInDegree[sampleNum] = sampleNum * 0.5;
+    float directionX = cos(anglesInDegree[sampleNum] * DEG_TO_RAD);
+    float directionY = sin(anglesInDegree[sampleNum] * DEG_TO_RAD);
+    float rangeX = fabs(directionX) > 1e-6 ? wallX[directionX > 0] / directionX : 1e9;
+    float rangeY = fabs(directionY) > 1e-6 ? wallY[directionY > 0] / directionY : 1e9;
+    rangesInMillimeter[sampleNum] = (rangeX < rangeY ? rangeX : rangeY) + random(-10, 11);
+  }
+
+  sensorYDLidarX4::LineSegmentExtractor lineSegmentExtractor(1024, 64);
+  const int frameIterations = 100;
+  unsigned long start = micros();
+  for(int i=0; i<frameIterations; i++){
+    sink ^= lineSegmentExtractor.extract(anglesInDegree, rangesInMillimeter, sampleQuantity);
+  }
+  float microsecondsPerFrame = (float)(micros() - start) / frameIterations;
+  Serial.printf("%-32s %10.1f us/frame (%u segments)\n", "line segments", microsecondsPerFrame, lineSegmentExtractor.getSegmentCount());
+}
+
+void setup(){
+  Serial.begin(115200);
+  for(size_t i=0; i<sizeof(paket); i++){
+    paket[i] = random(256);
+  }
+}
+
+void loop(){
+  Serial.println("--- benchmark ---");
+  benchmarkChecksum();
+  benchmarkAngleCorrections();
+  benchmarkAngleInterpolations();
+  benchmarkCartesian();
+  benchmarkOccupancyGrid();
+  benchmarkLineSegments();
+  delay(5000);
+}
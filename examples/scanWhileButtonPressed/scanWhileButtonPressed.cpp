@@ -54,10 +54,11 @@ void setup(){
 
 void printLidarStatus(){
   Serial.printf(
-    "pkg:%lu[+%d]\tserial:%d Byte\tlidar:%lu/%lu/%lu Byte\n",
+    "pkg:%lu[+%d]\tserial:%d Byte\tlidar:%lu/%lu/%lu Byte\tingest:%.1f/%lu Byte\n",
     pkgs, pkgs-lastPkgs,
     LIDAR_SERIAL.available(),
-    lidar->getQueueCapacity(), lidar->getMaxUsedQueueSize(), lidar->getQueueSize()
+    lidar->getQueueCapacity(), lidar->getMaxUsedQueueSize(), lidar->getQueueSize(),
+    lidar->getAverageBytesPerIngest(), lidar->getMaxBytesPerIngest()
   );
   lastPkgs = pkgs;
 }
@@ -67,7 +68,7 @@ void checkButtonStateAndToggleLidar(){
   if(buttonPressed){
     if(!lidar->isScanning()){
       Serial.println("=> starting lidar ...");
-      Serial.println("pkg:<count>[+<diff>]\tserial:<buffersize> Byte\tlidar:<buffermax>/<maxused>/<current> Byte\n");
+      Serial.println("pkg:<count>[+<diff>]\tserial:<buffersize> Byte\tlidar:<buffermax>/<maxused>/<current> Byte\tingest:<average>/<max> Byte\n");
       lidar->start();
     }
   }else{
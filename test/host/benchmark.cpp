@@ -0,0 +1,221 @@
+/*
+host version of examples/benchmark for the kernels without an Arduino dependency
+
+build and run from this directory:
+  g++ -std=c++11 -O2 -I../.. benchmark.cpp ../../AngleCorrection.cpp ../../AngleInterpolation.cpp \
+    ../../OccupancyGrid.cpp ../../CartesianConverter.cpp ../../LineSegmentExtractor.cpp \
+    ../../FrameAssembler.cpp -o benchmark && ./benchmark
+
+the exit code is the number of failed checks
+*/
+
+#include <AngleCorrection.h>
+#include <AngleInterpolation.h>
+#include <OccupancyGrid.h>
+#include <LineSegmentExtractor.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+
+#define BENCHMARK_ITERATIONS 1000000
+
+typedef std::chrono::steady_clock Clock;
+
+volatile float floatSink;
+int failures = 0;
+
+double secondsSince(Clock::time_point start){
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void printSamplesPerSecond(const char *name, double seconds, size_t samplesPerCall){
+  printf("%-32s %12.0f samples/s\n", name, BENCHMARK_ITERATIONS * samplesPerCall / seconds);
+}
+
+void printNanosecondsPerCall(const char *name, double seconds){
+  printf("%-32s %12.2f ns/call\n", name, seconds * 1e9 / BENCHMARK_ITERATIONS);
+}
+
+// the formula of the X4 manual in double precision
+double atanCorrectionInDegree(uint16_t distance){
+  double distanceInMillimeter = distance / 4.0;
+  if(distanceInMillimeter == 0){
+    return 0;
+  }
+  return atan(21.8 * (155.3 - distanceInMillimeter) / (155.3 * distanceInMillimeter)) * 180 / M_PI;
+}
+
+// max abs error against atan over all raw distances (and over the X4 range 0.12m - 10m)
+void checkAngleCorrection(const char *name, sensorYDLidarX4::AngleCorrection &angleCorrection, double maxErrorInDegree, double maxErrorInRangeInDegree){
+  double maxError = 0, maxErrorInRange = 0;
+  for(uint32_t distance=0; distance<=UINT16_MAX; distance++){
+    double error = fabs(angleCorrection.inDegree(distance) - atanCorrectionInDegree(distance));
+    maxError = error > maxError ? error : maxError;
+    if(distance >= 480 && distance <= 40000){
+      maxErrorInRange = error > maxErrorInRange ? error : maxErrorInRange;
+    }
+  }
+  bool isPassed = maxError <= maxErrorInDegree && maxErrorInRange <= maxErrorInRangeInDegree;
+  printf("%-32s max error %.4f (0.12m-10m %.4f) degree, bound %.4f (%.4f) %s\n", name, maxError, maxErrorInRange, maxErrorInDegree, maxErrorInRangeInDegree, isPassed ? "ok" : "FAILED");
+  if(!isPassed){
+    failures++;
+  }
+}
+
+void benchmarkAngleCorrection(const char *name, sensorYDLidarX4::AngleCorrection &angleCorrection){
+  // raw distances of the X4 range 0.12m - 10m in 0.25mm steps
+  Clock::time_point start = Clock::now();
+  for(int i=0; i<BENCHMARK_ITERATIONS; i++){
+    uint16_t distance = 480 + (i * 4) % 39520;
+    floatSink += angleCorrection.inDegree(distance);
+  }
+  printNanosecondsPerCall(name, secondsSince(start));
+}
+
+// the exact mode is the atan of the formula, the others are the look up tables
+void benchmarkAngleCorrections(){
+  sensorYDLidarX4::AngleCorrection exact;
+  checkAngleCorrection("angle correction exact (atan)", exact, 0.0001, 0.0001);
+  benchmarkAngleCorrection("angle correction exact (atan)", exact);
+
+  sensorYDLidarX4::AngleCorrection interpolated;
+  interpolated.setMode(sensorYDLidarX4::ANGLE_CORRECTION_INTERPOLATED);
+  checkAngleCorrection("angle correction interpolated", interpolated, 0.006, 0.003);
+  benchmarkAngleCorrection("angle correction interpolated", interpolated);
+
+  sensorYDLidarX4::AngleCorrection table;
+  if(table.setMode(sensorYDLidarX4::ANGLE_CORRECTION_TABLE)){
+    checkAngleCorrection("angle correction table", table, 0.002, 0.002);
+    benchmarkAngleCorrection("angle correction table", table);
+  }else{
+    printf("angle correction table: not enough heap\n");
+  }
+}
+
+// the per sample path before the kernel, as YDLidarX4StateMachine::calculateAngleInDegree() was
+float calculateAngleInDegree(sensorYDLidarX4::AngleCorrection &angleCorrection, uint16_t distance_i, float startAngleInDegree, float stopAngleInDegree, uint16_t sampleNum, uint8_t sampleQuantity){
+  float angleInDegree_i;
+  if(sampleQuantity==1){
+    // prevent DIV0-error
+    angleInDegree_i = startAngleInDegree;
+  }else{
+    angleInDegree_i = startAngleInDegree + sampleNum * (stopAngleInDegree - startAngleInDegree)/(sampleQuantity - 1);
+  }
+  float angleInDegree_correced_i = angleInDegree_i + angleCorrection.inDegree(distance_i);
+  return angleInDegree_correced_i;
+}
+
+// one scan paket with 40 samples (the usual X4 paket size) per iteration,
+// ranges and corrected angles as calculateRangesAndAnglesFromPaket() before and after the kernel
+void benchmarkAngleInterpolation(const char *name, sensorYDLidarX4::AngleCorrection &angleCorrection){
+  const size_t sampleQuantity = 40;
+  uint16_t distances[sampleQuantity];
+  float rangesInMillimeter[sampleQuantity];
+  float anglesInDegree[sampleQuantity];
+  for(size_t sampleNum=0; sampleNum<sampleQuantity; sampleNum++){
+    distances[sampleNum] = 480 + rand() % 39520;
+  }
+  char label[64];
+
+  Clock::time_point start = Clock::now();
+  for(int i=0; i<BENCHMARK_ITERATIONS; i++){
+    float startAngleInDegree = i % 360;
+    float stopAngleInDegree = startAngleInDegree + 20;
+    for(size_t sampleNum=0; sampleNum<sampleQuantity; sampleNum++){
+      rangesInMillimeter[sampleNum] = distances[sampleNum]/4.0;
+      anglesInDegree[sampleNum] = calculateAngleInDegree(angleCorrection, distances[sampleNum], startAngleInDegree, stopAngleInDegree, sampleNum, sampleQuantity);
+    }
+    floatSink += rangesInMillimeter[i % sampleQuantity] + anglesInDegree[i % sampleQuantity];
+  }
+  snprintf(label, sizeof(label), "per sample (%s)", name);
+  printSamplesPerSecond(label, secondsSince(start), sampleQuantity);
+
+  start = Clock::now();
+  for(int i=0; i<BENCHMARK_ITERATIONS; i++){
+    float startAngleInDegree = i % 360;
+    float stopAngleInDegree = startAngleInDegree + 20;
+    sensorYDLidarX4::distancesInMillimeter(distances, sampleQuantity, rangesInMillimeter);
+    sensorYDLidarX4::interpolateAnglesInDegree(startAngleInDegree, stopAngleInDegree, sampleQuantity, anglesInDegree);
+    for(size_t sampleNum=0; sampleNum<sampleQuantity; sampleNum++){
+      anglesInDegree[sampleNum] = sensorYDLidarX4::wrapAngleInDegree(anglesInDegree[sampleNum] + angleCorrection.inDegree(distances[sampleNum]));
+    }
+    floatSink += rangesInMillimeter[i % sampleQuantity] + anglesInDegree[i % sampleQuantity];
+  }
+  snprintf(label, sizeof(label), "kernel (%s)", name);
+  printSamplesPerSecond(label, secondsSince(start), sampleQuantity);
+}
+
+void benchmarkAngleInterpolations(){
+  sensorYDLidarX4::AngleCorrection exact;
+  benchmarkAngleInterpolation("exact", exact);
+
+  sensorYDLidarX4::AngleCorrection interpolated;
+  interpolated.setMode(sensorYDLidarX4::ANGLE_CORRECTION_INTERPOLATED);
+  benchmarkAngleInterpolation("interpolated", interpolated);
+
+  sensorYDLidarX4::AngleCorrection table;
+  if(table.setMode(sensorYDLidarX4::ANGLE_CORRECTION_TABLE)){
+    benchmarkAngleInterpolation("table", table);
+  }
+}
+
+// rays of 40 samples up to 5m into a 10m x 10m grid with 5cm cells
+void benchmarkOccupancyGrid(){
+  const size_t sampleQuantity = 40;
+  uint16_t anglesInQ6Degree[sampleQuantity];
+  uint16_t rangesInQuarterMillimeter[sampleQuantity];
+  for(size_t sampleNum=0; sampleNum<sampleQuantity; sampleNum++){
+    anglesInQ6Degree[sampleNum] = rand() % (360*64);
+    rangesInQuarterMillimeter[sampleNum] = 1 + rand() % 20000;
+  }
+
+  sensorYDLidarX4::OccupancyGrid occupancyGrid(200, 200, 50);
+  occupancyGrid.setPose(5000, 5000, 0);
+  Clock::time_point start = Clock::now();
+  for(int i=0; i<BENCHMARK_ITERATIONS; i++){
+    occupancyGrid.update(anglesInQ6Degree, rangesInQuarterMillimeter, sampleQuantity);
+  }
+  double seconds = secondsSince(start);
+  printSamplesPerSecond("occupancy grid", seconds, sampleQuantity);
+  printf("%-32s %12.0f cells/s\n", "occupancy grid", occupancyGrid.getCellUpdateCount() / seconds);
+}
+
+// one revolution of 720 samples in a 6m x 4m room, the lidar 1m/0.5m off center.
+// there is no recorded scan in the repo, so the scan is synthetic with +-10mm noise
+void benchmarkLineSegments(){
+  const size_t sampleQuantity = 720;
+  static float anglesInDegree[sampleQuantity];
+  static float rangesInMillimeter[sampleQuantity];
+  const float wallX[2] = {-4000, 2000};
+  const float wallY[2] = {-2500, 1500};
+  for(size_t sampleNum=0; sampleNum<sampleQuantity; sampleNum++){
+    anglesInDegree[sampleNum] = sampleNum * 0.5f;
+    float directionX = cos(anglesInDegree[sampleNum] * M_PI / 180);
+    float directionY = sin(anglesInDegree[sampleNum] * M_PI / 180);
+    float rangeX = fabs(directionX) > 1e-6 ? wallX[directionX > 0] / directionX : 1e9;
+    float rangeY = fabs(directionY) > 1e-6 ? wallY[directionY > 0] / directionY : 1e9;
+    rangesInMillimeter[sampleNum] = (rangeX < rangeY ? rangeX : rangeY) + rand() % 21 - 10;
+  }
+
+  sensorYDLidarX4::LineSegmentExtractor lineSegmentExtractor(1024, 64);
+  const int frameIterations = 1000;
+  size_t segmentCount = 0;
+  Clock::time_point start = Clock::now();
+  for(int i=0; i<frameIterations; i++){
+    segmentCount += lineSegmentExtractor.extract(anglesInDegree, rangesInMillimeter, sampleQuantity);
+  }
+  double seconds = secondsSince(start);
+  printf("%-32s %12.1f us/frame (%zu segments)\n", "line segments", seconds * 1e6 / frameIterations, segmentCount / frameIterations);
+  printf("%-32s %12.0f samples/s\n", "line segments", frameIterations * sampleQuantity / seconds);
+}
+
+int main(){
+  srand(1);
+  benchmarkAngleCorrections();
+  benchmarkAngleInterpolations();
+  benchmarkOccupancyGrid();
+  benchmarkLineSegments();
+  return failures;
+}
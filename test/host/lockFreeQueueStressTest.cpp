@@ -0,0 +1,144 @@
+/*
+host stress test of the LockFreeQueue with one producer and one consumer thread
+
+the producer writes a byte sequence with add (single and block) and
+reserve/commit like the serial receiver, the consumer reads it back with get,
+peek, view, extract, dequeue and remove like the state machine. every byte is
+checked against the sequence, the exit code is 1 on any mismatch.
+
+build and run from this directory:
+  g++ -std=c++11 -O2 -I../.. lockFreeQueueStressTest.cpp -o lockFreeQueueStressTest -lpthread && ./lockFreeQueueStressTest
+*/
+
+#include <LockFreeQueue.h>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+
+using sensorYDLidarX4::LockFreeQueue;
+
+const uint32_t totalBytes = 2000000;
+
+// a multiplicative hash, so a lost or doubled block of 256 bytes is a mismatch too
+uint8_t expectedByte(uint32_t position){
+  return (uint8_t)((position * 2654435761u) >> 24);
+}
+
+void produce(LockFreeQueue<uint8_t> &queue){
+  uint32_t position = 0;
+  uint8_t block[7];
+  while(position < totalBytes){
+    if(queue.isFull()){
+      std::this_thread::yield();
+      continue;
+    }
+    uint32_t left = totalBytes - position;
+    switch(position % 3){
+      case 2:{
+        uint8_t *span;
+        size_t spanSize = queue.reserve(span);
+        size_t size = spanSize < left ? spanSize : left;
+        for(size_t index=0; index<size; index++){
+          span[index] = expectedByte(position + index);
+        }
+        queue.commit(size);
+        position += size;
+        break;
+      }
+      case 1:
+        if(left >= sizeof(block)){
+          for(uint32_t index=0; index<sizeof(block); index++){
+            block[index] = expectedByte(position + index);
+          }
+          if(queue.add(block, sizeof(block))){
+            position += sizeof(block);
+          }
+          break;
+        }
+        // fall through
+      default:
+        if(queue.add(expectedByte(position))){
+          position++;
+        }
+    }
+  }
+}
+
+int main(){
+  LockFreeQueue<uint8_t> queue(361);
+  std::thread producer(produce, std::ref(queue));
+
+  uint32_t position = 0;
+  unsigned long mismatches = 0;
+  uint8_t buffer[13];
+  while(position < totalBytes){
+    size_t size = queue.size();
+    if(size == 0){
+      std::this_thread::yield();
+      continue;
+    }
+    switch(position % 5){
+      case 0:
+        if(queue.get(0) != expectedByte(position)){
+          mismatches++;
+        }
+        queue.remove(1);
+        position++;
+        break;
+      case 1:
+        if(queue.dequeue() != expectedByte(position)){
+          mismatches++;
+        }
+        position++;
+        break;
+      case 2:{
+        size_t peeked = queue.peek(0, buffer, sizeof(buffer));
+        for(size_t index=0; index<peeked; index++){
+          if(buffer[index] != expectedByte(position + index)){
+            mismatches++;
+          }
+        }
+        queue.remove(peeked);
+        position += peeked;
+        break;
+      }
+      case 3:{
+        sensorYDLidarX4::LidarQueueView<uint8_t> view;
+        size_t viewSize = size < sizeof(buffer) ? size : sizeof(buffer);
+        if(queue.view(viewSize, view)){
+          for(size_t index=0; index<view.firstSize; index++){
+            if(view.first[index] != expectedByte(position + index)){
+              mismatches++;
+            }
+          }
+          for(size_t index=0; index<view.secondSize; index++){
+            if(view.second[index] != expectedByte(position + view.firstSize + index)){
+              mismatches++;
+            }
+          }
+          queue.remove(viewSize);
+          position += viewSize;
+        }
+        break;
+      }
+      default:
+        if(size >= sizeof(buffer) && queue.extract(buffer, sizeof(buffer))){
+          for(size_t index=0; index<sizeof(buffer); index++){
+            if(buffer[index] != expectedByte(position + index)){
+              mismatches++;
+            }
+          }
+          position += sizeof(buffer);
+        }else{
+          if(queue.dequeue() != expectedByte(position)){
+            mismatches++;
+          }
+          position++;
+        }
+    }
+  }
+  producer.join();
+
+  printf("%u bytes, %lu mismatches, %zu left in the queue\n", totalBytes, mismatches, queue.size());
+  return mismatches == 0 && queue.isEmpty() ? 0 : 1;
+}
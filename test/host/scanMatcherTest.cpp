@@ -0,0 +1,127 @@
+/*
+host test of the ScanMatcher on a synthetic room
+
+the lidar moves through a 6m x 4m room with a box and a diagonal wall, every
+step casts one revolution of 720 rays with +-10mm range noise. the matched
+motion has to stay within the error bounds below. a scan of a single straight
+wall can not be solved and has to be invalid. the exit code is the number of
+failed checks.
+
+build and run from this directory:
+  g++ -std=c++11 -O2 -I../.. scanMatcherTest.cpp ../../ScanMatcher.cpp ../../FrameAssembler.cpp \
+    -o scanMatcherTest && ./scanMatcherTest
+*/
+
+#include <ScanMatcher.h>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+using sensorYDLidarX4::ScanMatcher;
+using sensorYDLidarX4::ScanMatchResult;
+
+const float maxTranslationErrorInMillimeter = 10;
+const float maxRotationErrorInDegree = 0.2f;
+const size_t sampleQuantity = 720;
+const float noiseInMillimeter = 10;
+const int steps = 40;
+
+struct Wall{
+  float x0, y0, x1, y1;
+};
+
+const Wall walls[] = {
+  {-4000, -2500,  2000, -2500}, { 2000, -2500,  2000,  1500},
+  { 2000,  1500, -4000,  1500}, {-4000,  1500, -4000, -2500},
+  {  500,   500,   900,   500}, {  900,   500,   900,   900},
+  {  900,   900,   500,   900}, {  500,   900,   500,   500},
+  {-2000, -1000, -1500, -1800}
+};
+
+int failures = 0;
+
+void check(bool condition, const char *message, int step){
+  if(!condition){
+    printf("FAILED step %d: %s\n", step, message);
+    failures++;
+  }
+}
+
+// range to the nearest wall, 0 beyond 10m
+float castRay(float x, float y, float angleInRad){
+  float directionX = cosf(angleInRad);
+  float directionY = sinf(angleInRad);
+  float nearest = 1e9f;
+  for(const Wall &wall : walls){
+    float edgeX = wall.x1 - wall.x0;
+    float edgeY = wall.y1 - wall.y0;
+    float denominator = directionX * edgeY - directionY * edgeX;
+    if(fabsf(denominator) < 1e-9f){
+      continue;
+    }
+    float range = ((wall.x0 - x) * edgeY - (wall.y0 - y) * edgeX) / denominator;
+    float along = ((wall.x0 - x) * directionY - (wall.y0 - y) * directionX) / denominator;
+    if(range > 0 && along >= 0 && along <= 1 && range < nearest){
+      nearest = range;
+    }
+  }
+  return nearest > 10000 ? 0 : nearest;
+}
+
+void scan(float x, float y, float headingInDegree, float anglesInDegree[], float rangesInMillimeter[]){
+  for(size_t sampleNum=0; sampleNum<sampleQuantity; sampleNum++){
+    anglesInDegree[sampleNum] = sampleNum * 360.0f / sampleQuantity;
+    float range = castRay(x, y, (anglesInDegree[sampleNum] + headingInDegree) * (float)M_PI / 180);
+    if(range > 0){
+      range += noiseInMillimeter * ((rand() % 2001) / 1000.0f - 1);
+    }
+    rangesInMillimeter[sampleNum] = range;
+  }
+}
+
+int main(){
+  static float anglesInDegree[sampleQuantity];
+  static float rangesInMillimeter[sampleQuantity];
+  ScanMatcher scanMatcher(1024);
+  ScanMatchResult result;
+  srand(5);
+
+  float x = 0, y = 0, headingInDegree = 0;
+  scan(x, y, headingInDegree, anglesInDegree, rangesInMillimeter);
+  check(!scanMatcher.match(anglesInDegree, rangesInMillimeter, sampleQuantity, result), "first scan has no reference", 0);
+
+  float maxTranslationError = 0, maxRotationError = 0;
+  for(int step=1; step<=steps; step++){
+    // known motion in the frame of the previous scan
+    float dx = 60 * cosf(step * 0.3f);
+    float dy = 40 * sinf(step * 0.2f);
+    float dRotation = 3 * sinf(step * 0.5f);
+    float cosine = cosf(headingInDegree * (float)M_PI / 180);
+    float sine = sinf(headingInDegree * (float)M_PI / 180);
+    x += cosine * dx - sine * dy;
+    y += sine * dx + cosine * dy;
+    headingInDegree += dRotation;
+
+    scan(x, y, headingInDegree, anglesInDegree, rangesInMillimeter);
+    bool isValid = scanMatcher.match(anglesInDegree, rangesInMillimeter, sampleQuantity, result);
+    float translationError = hypotf(result.xInMillimeter - dx, result.yInMillimeter - dy);
+    float rotationError = fabsf(result.rotationInDegree - dRotation);
+    check(isValid, "match is valid", step);
+    check(translationError <= maxTranslationErrorInMillimeter, "translation error", step);
+    check(rotationError <= maxRotationErrorInDegree, "rotation error", step);
+    maxTranslationError = fmaxf(maxTranslationError, translationError);
+    maxRotationError = fmaxf(maxRotationError, rotationError);
+  }
+
+  // only one wall in view: the motion along the wall is unknown
+  for(size_t sampleNum=0; sampleNum<sampleQuantity; sampleNum++){
+    anglesInDegree[sampleNum] = sampleNum * 60.0f / sampleQuantity - 30;
+    rangesInMillimeter[sampleNum] = 1000 / cosf(anglesInDegree[sampleNum] * (float)M_PI / 180);
+  }
+  scanMatcher.reset();
+  scanMatcher.match(anglesInDegree, rangesInMillimeter, sampleQuantity, result);
+  check(!scanMatcher.match(anglesInDegree, rangesInMillimeter, sampleQuantity, result), "single wall is invalid", steps+1);
+
+  printf("max translation error %.2f mm, max rotation error %.3f degree, %d failed\n", maxTranslationError, maxRotationError, failures);
+  return failures;
+}